@@ -1,17 +1,116 @@
+#include "lox/include/Batch.h"
 #include "lox/include/Lox.h"
+#include "lox/include/Profiler.h"
+#include "lox/include/Server.h"
+
+#include <charconv>
+#include <fstream>
+#include <memory>
+#include <string>
+
+namespace
+{
+int usage()
+{
+    std::cout << "Usage: lox-cpp [--report] [--lazy] [--cache] [--cache-dir=dir] [--profile[=file]]\n"
+                 "               [--line-profile] [script]\n"
+                 "       lox-cpp [--report] [--lazy] --serve=socket [--prelude=script] [--fork]\n"
+                 "       lox-cpp [--report] [--lazy] [--cache] [--threads=n] --batch dir\n"
+                 "       lox-cpp --submit=socket script"
+              << std::endl;
+    return EXIT_FAILURE;
+}
+} // namespace
 
 int main(int argc, char *argv[])
 {
-    if (argc > 2) // too many arguments
+    lox::Lox::Options options;
+    lox::Server::Options server;
+    lox::Batch::Options batch;
+    bool runBatch = false;
+    std::string submitTo;
+    std::string profile; // where the folded stacks go
+    std::string script;
+
+    for (int i = 1; i < argc; ++i)
     {
-        std::cout << "Usage: lox-cpp [script]" << std::endl;
-        return EXIT_FAILURE;
+        const std::string arg = argv[i];
+
+        if (arg == "--report")
+            options.report = true;
+        else if (arg == "--lazy")
+            options.lazy = true;
+        else if (arg == "--cache")
+            options.cache = true;
+        else if (arg.starts_with("--cache-dir="))
+        {
+            options.cache = true;
+            options.cacheDir = arg.substr(std::string{"--cache-dir="}.size());
+        }
+        else if (arg.starts_with("--serve="))
+            server.socketPath = arg.substr(std::string{"--serve="}.size());
+        else if (arg.starts_with("--prelude="))
+            server.prelude = arg.substr(std::string{"--prelude="}.size());
+        else if (arg == "--fork")
+            server.fork = true;
+        else if (arg == "--batch")
+            runBatch = true;
+        else if (arg.starts_with("--threads="))
+        {
+            // the whole rest has to be the number
+            const char *const begin = arg.data() + std::string{"--threads="}.size();
+            const char *const end = arg.data() + arg.size();
+            const auto [parsed, error] = std::from_chars(begin, end, batch.threads);
+            if (error != std::errc{} || parsed != end)
+                return usage();
+        }
+        else if (arg == "--profile")
+            profile = "profile.folded";
+        else if (arg.starts_with("--profile="))
+            profile = arg.substr(std::string{"--profile="}.size());
+        else if (arg == "--line-profile")
+            options.lineProfile = true;
+        else if (arg.starts_with("--submit="))
+            submitTo = arg.substr(std::string{"--submit="}.size());
+        else if (!arg.starts_with("--") && script.empty())
+            script = arg;
+        else // unknown option or too many arguments
+            return usage();
     }
 
-    lox::Lox lox;
+    if (!submitTo.empty())
+        return lox::Server::submit(submitTo, script);
+
+    if (runBatch)
+    {
+        batch.directory = script.empty() ? "." : script;
+        return lox::Batch{batch, options}.run();
+    }
+
+    lox::Lox lox{options};
+
+    if (!server.socketPath.empty())
+    {
+        lox::Server serve{server, lox};
+        return serve.serve();
+    }
+
+    if (!script.empty())
+    {
+        // only around the script, the isolate (and the names the samples point to) outlives it
+        std::unique_ptr<lox::Profiler> profiler = profile.empty() ? nullptr : std::make_unique<lox::Profiler>();
+        const bool success = lox.runFile(std::move(script));
+
+        if (profiler)
+        {
+            std::ofstream folded{profile};
+            profiler->write(folded);
+            if (!folded)
+                std::cerr << "Could not write the profile to '" << profile << "'." << std::endl;
+        }
+
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
 
-    if (argc == 2)
-        lox.runFile(argv[1]);
-    else
-        lox.runPrompt();
+    lox.runPrompt();
 }
@@ -0,0 +1,61 @@
+#include "Allocations.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+std::atomic<std::uint64_t> allocationCount{0};
+std::atomic<std::uint64_t> allocatedByteCount{0};
+
+void *allocate(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedByteCount.fetch_add(size, std::memory_order_relaxed);
+
+    if (void *memory = std::malloc(size == 0 ? 1 : size))
+        return memory;
+    throw std::bad_alloc{};
+}
+} // namespace
+
+std::uint64_t bench::allocations()
+{
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+std::uint64_t bench::allocatedBytes()
+{
+    return allocatedByteCount.load(std::memory_order_relaxed);
+}
+
+// every allocation of the interpreter is counted, the other forms of new end up here too
+void *operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void *operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
@@ -0,0 +1,16 @@
+#ifndef ALLOCATIONS_H
+#define ALLOCATIONS_H
+
+#include <cstdint>
+
+namespace bench
+{
+
+// every operator new of a benchmark executable is counted (Allocations.cpp replaces it), the counts only go up.
+// a measurement takes the difference around the code it measures
+std::uint64_t allocations();
+std::uint64_t allocatedBytes();
+
+} // namespace bench
+
+#endif
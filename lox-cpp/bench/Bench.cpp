@@ -0,0 +1,406 @@
+// benchmark harness: runs every .lox program of a directory a number of times in-process, each run in a fresh
+// isolate, and reports the wall time, peak rss and allocations of the runs. the results can be saved as a json
+// baseline and later runs compared against it, a program that got slower than the threshold fails the harness.
+//
+//   cmake -S . -B build && cmake --build build --target lox-bench
+//   build/lox-bench [--runs=n] [--save=file] [--baseline=file] [--threshold=percent] [dir] [name...]
+
+#include "../lox/include/Lox.h"
+#include "Allocations.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <malloc.h>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct Options
+{
+    std::size_t runs{10};
+    std::string directory{"bench"};
+    std::vector<std::string> names; // all programs, if empty
+    std::string save;
+    std::string baseline;
+    double threshold{5}; // percent the median may get slower
+};
+
+struct Result
+{
+    double mean{0};
+    double median{0};
+    double stddev{0};
+    double p99{0};
+    double peakRss{0};     // kB, the highest of the runs
+    double allocations{0}; // per run
+    double bytes{0};       // allocated per run
+};
+
+using Results = std::map<std::string, Result>;
+
+// the peak rss of the process is reset before every program, where the kernel allows it. the memory the earlier
+// programs freed goes back first, or it would count for this one
+bool resetPeakRss()
+{
+    malloc_trim(0);
+
+    std::ofstream clear{"/proc/self/clear_refs"};
+    return static_cast<bool>(clear << "5" << std::flush);
+}
+
+double peakRss()
+{
+    std::ifstream status{"/proc/self/status"};
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.starts_with("VmHWM:"))
+            return std::stod(line.substr(6));
+    }
+    return 0;
+}
+
+double percentile(const std::vector<double> &sorted, double percent)
+{
+    // nearest rank
+    const auto rank = static_cast<std::size_t>(std::ceil(percent / 100 * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+}
+
+// nullopt if a run failed, its errors are printed
+std::optional<Result> measure(const std::string &sourceCode, std::size_t runs)
+{
+    using clock = std::chrono::steady_clock;
+
+    std::vector<double> times;
+    std::uint64_t allocated = 0;
+    std::uint64_t bytes = 0;
+
+    resetPeakRss();
+
+    // the first run only warms up the caches and the task pool
+    for (std::size_t run = 0; run <= runs; ++run)
+    {
+        std::ostringstream out;
+        std::ostringstream err;
+
+        const std::uint64_t allocatedBefore = bench::allocations();
+        const std::uint64_t bytesBefore = bench::allocatedBytes();
+        const clock::time_point start = clock::now();
+
+        bool failed;
+        {
+            lox::Lox lox{{}, out, err};
+            lox.run(sourceCode);
+            failed = lox.hadError() || lox.hadRuntimeError();
+        }
+
+        const clock::time_point end = clock::now();
+
+        if (failed)
+        {
+            std::cerr << err.str();
+            return std::nullopt;
+        }
+
+        if (run == 0)
+            continue;
+
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        allocated += bench::allocations() - allocatedBefore;
+        bytes += bench::allocatedBytes() - bytesBefore;
+    }
+
+    Result result;
+    const double n = static_cast<double>(runs);
+
+    result.mean = std::accumulate(times.begin(), times.end(), 0.0) / n;
+    for (const double time : times)
+        result.stddev += (time - result.mean) * (time - result.mean);
+    result.stddev = runs > 1 ? std::sqrt(result.stddev / (n - 1)) : 0;
+
+    std::sort(times.begin(), times.end());
+    result.median = runs % 2 == 1 ? times[runs / 2] : (times[runs / 2 - 1] + times[runs / 2]) / 2;
+    result.p99 = percentile(times, 99);
+
+    result.peakRss = peakRss();
+
+    result.allocations = static_cast<double>(allocated) / n;
+    result.bytes = static_cast<double>(bytes) / n;
+    return result;
+}
+
+// ---- baseline ----
+
+const std::vector<std::pair<std::string, double Result::*>> fields = {
+    {"mean_ms", &Result::mean},          {"median_ms", &Result::median},
+    {"stddev_ms", &Result::stddev},      {"p99_ms", &Result::p99},
+    {"peak_rss_kb", &Result::peakRss},   {"allocations", &Result::allocations},
+    {"allocated_bytes", &Result::bytes},
+};
+
+bool save(const std::string &path, const Results &results)
+{
+    std::ofstream out{path};
+    out << std::setprecision(12) << "{\n";
+
+    for (auto program = results.begin(); program != results.end(); ++program)
+    {
+        out << "  \"" << program->first << "\": {";
+        for (std::size_t i = 0; i < fields.size(); ++i)
+            out << (i ? ", " : "") << "\"" << fields[i].first << "\": " << program->second.*fields[i].second;
+        out << "}" << (std::next(program) != results.end() ? "," : "") << "\n";
+    }
+
+    out << "}\n";
+    return static_cast<bool>(out);
+}
+
+// only what save writes: an object of programs, each an object of numbers
+class BaselineReader
+{
+  public:
+    explicit BaselineReader(std::string text) : _text{std::move(text)}
+    {
+    }
+
+    std::optional<Results> read()
+    {
+        Results results;
+        if (!expect('{'))
+            return std::nullopt;
+
+        while (!peek('}'))
+        {
+            std::string name;
+            if (!string(name) || !expect(':') || !expect('{'))
+                return std::nullopt;
+
+            Result &result = results[name];
+            while (!peek('}'))
+            {
+                std::string field;
+                double value;
+                if (!string(field) || !expect(':') || !number(value))
+                    return std::nullopt;
+
+                for (const auto &[key, member] : fields)
+                {
+                    if (key == field)
+                        result.*member = value;
+                }
+                peek(',');
+            }
+            peek(',');
+        }
+
+        return results;
+    }
+
+  private:
+    void skipSpace()
+    {
+        while (_pos < _text.size() && std::isspace(static_cast<unsigned char>(_text[_pos])))
+            ++_pos;
+    }
+
+    bool expect(char c)
+    {
+        skipSpace();
+        if (_pos >= _text.size() || _text[_pos] != c)
+            return false;
+        ++_pos;
+        return true;
+    }
+
+    bool peek(char c) // consumes c, if it's next
+    {
+        skipSpace();
+        if (_pos >= _text.size() || _text[_pos] != c)
+            return false;
+        ++_pos;
+        return true;
+    }
+
+    bool string(std::string &value)
+    {
+        if (!expect('"'))
+            return false;
+        const std::size_t end = _text.find('"', _pos);
+        if (end == std::string::npos)
+            return false;
+        value = _text.substr(_pos, end - _pos);
+        _pos = end + 1;
+        return true;
+    }
+
+    bool number(double &value)
+    {
+        skipSpace();
+        const char *begin = _text.c_str() + _pos;
+        char *end;
+        value = std::strtod(begin, &end);
+        _pos += static_cast<std::size_t>(end - begin);
+        return end != begin;
+    }
+
+    const std::string _text;
+    std::size_t _pos{0};
+};
+
+std::optional<Results> load(const std::string &path)
+{
+    std::ifstream in{path};
+    if (!in)
+        return std::nullopt;
+
+    std::stringstream text;
+    text << in.rdbuf();
+    return BaselineReader{text.str()}.read();
+}
+
+std::string change(double now, double before)
+{
+    if (before <= 0)
+        return "-";
+
+    std::ostringstream text;
+    text << std::showpos << std::fixed << std::setprecision(1) << (now - before) / before * 100 << "%";
+    return text.str();
+}
+
+int usage()
+{
+    std::cout << "Usage: lox-bench [--runs=n] [--save=file] [--baseline=file] [--threshold=percent] [dir] [name...]"
+              << std::endl;
+    return EXIT_FAILURE;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    bool directorySet = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+
+        if (arg.starts_with("--runs="))
+            options.runs = std::max<std::size_t>(std::stoul(arg.substr(std::string{"--runs="}.size())), 1);
+        else if (arg.starts_with("--save="))
+            options.save = arg.substr(std::string{"--save="}.size());
+        else if (arg.starts_with("--baseline="))
+            options.baseline = arg.substr(std::string{"--baseline="}.size());
+        else if (arg.starts_with("--threshold="))
+            options.threshold = std::stod(arg.substr(std::string{"--threshold="}.size()));
+        else if (arg.starts_with("--"))
+            return usage();
+        else if (!directorySet && std::filesystem::is_directory(arg))
+        {
+            options.directory = arg;
+            directorySet = true;
+        }
+        else
+            options.names.push_back(arg);
+    }
+
+    std::optional<Results> baseline;
+    if (!options.baseline.empty() && !(baseline = load(options.baseline)))
+    {
+        std::cerr << "Could not read the baseline '" << options.baseline << "'." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::filesystem::path> programs;
+    for (const auto &entry : std::filesystem::directory_iterator{options.directory})
+    {
+        const std::string name = entry.path().stem().string();
+        const bool chosen =
+            options.names.empty() || std::find(options.names.begin(), options.names.end(), name) != options.names.end();
+        if (entry.path().extension() == ".lox" && chosen)
+            programs.push_back(entry.path());
+    }
+    std::sort(programs.begin(), programs.end());
+
+    if (programs.empty())
+    {
+        std::cerr << "No programs in '" << options.directory << "'." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!resetPeakRss())
+        std::cerr << "The peak rss can't be reset, it is the peak of the process so far." << std::endl;
+
+    std::cout << std::left << std::setw(16) << "program" << std::right << std::setw(10) << "mean ms" << std::setw(11)
+              << "median ms" << std::setw(11) << "stddev ms" << std::setw(10) << "p99 ms" << std::setw(14)
+              << "peak rss kB" << std::setw(14) << "allocs/run" << std::setw(14) << "MB/run";
+    if (baseline)
+        std::cout << std::setw(10) << "median" << std::setw(10) << "allocs";
+    std::cout << "\n" << std::fixed;
+
+    Results results;
+    bool failed = false;
+    for (const std::filesystem::path &path : programs)
+    {
+        std::ifstream file{path};
+        std::stringstream source;
+        source << file.rdbuf();
+
+        const std::string name = path.stem().string();
+        const std::optional<Result> result = measure(source.str(), options.runs);
+        if (!result)
+        {
+            std::cout << std::left << std::setw(16) << name << std::right << "failed\n";
+            failed = true;
+            continue;
+        }
+        results[name] = *result;
+
+        std::cout << std::left << std::setw(16) << name << std::right << std::setprecision(2) << std::setw(10)
+                  << result->mean << std::setw(11) << result->median << std::setw(11) << result->stddev << std::setw(10)
+                  << result->p99 << std::setprecision(0) << std::setw(14) << result->peakRss << std::setw(14)
+                  << result->allocations << std::setprecision(2) << std::setw(14) << result->bytes / (1024 * 1024);
+
+        if (baseline)
+        {
+            if (const auto before = baseline->find(name); before != baseline->end())
+            {
+                std::cout << std::setw(10) << change(result->median, before->second.median) << std::setw(10)
+                          << change(result->allocations, before->second.allocations);
+
+                // slower by more than the threshold and more than the noise of both measurements
+                const double slower = result->median - before->second.median;
+                if (slower > before->second.median * options.threshold / 100 &&
+                    slower > result->stddev + before->second.stddev)
+                {
+                    std::cout << "  regression";
+                    failed = true;
+                }
+            }
+            else
+                std::cout << std::setw(10) << "new";
+        }
+        std::cout << std::endl;
+    }
+
+    if (!options.save.empty() && !save(options.save, results))
+    {
+        std::cerr << "Could not write the baseline '" << options.save << "'." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,460 @@
+// front end micro benchmark: Scanner::scanTokens and Parser::parse on their own, on generated corpora of
+// several shapes and sizes. reports the throughput of both (tokens/s, MB/s, AST nodes/s) and the bytes they
+// allocate per token. each measurement is repeated until it took a while, the median run counts.
+//
+//   cmake -S . -B build && cmake --build build --target lox-frontend
+//   build/lox-frontend [--sizes=1K,64K,1M,16M] [--min-time=ms] [--lazy] [--dump=dir] [corpus...]
+//
+// the corpora are nesting, identifiers, strings, comments and expressions. sizes take a K or M suffix, up to
+// 100M; the tokens of the biggest sizes take a few GB
+
+#include "../lox/include/AST/Expressions.h"
+#include "../lox/include/AST/Statements.h"
+#include "../lox/include/AST/Visitor.h"
+#include "../lox/include/ErrorHandler.h"
+#include "../lox/include/parsing/Parser.h"
+#include "../lox/include/scanning/Scanner.h"
+#include "Allocations.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+using namespace lox;
+
+// ---- corpora ----
+
+// every corpus is a valid script, built from numbered units until it has the size.
+// the numbers keep the units from being all the same text
+using Unit = std::function<void(std::string &out, std::size_t n)>;
+
+std::string generate(const Unit &unit, std::size_t size)
+{
+    std::string out;
+    out.reserve(size + 4096);
+    for (std::size_t n = 0; out.size() < size; ++n)
+        unit(out, n);
+    return out;
+}
+
+// blocks, ifs and loops 32 deep, with a parenthesized expression just as deep at the bottom
+void nesting(std::string &out, std::size_t n)
+{
+    constexpr int depth = 32;
+    const std::string i = std::to_string(n);
+
+    out += "fun nested" + i + "(a) {\n";
+    for (int level = 0; level < depth; ++level)
+    {
+        switch (level % 3)
+        {
+        case 0:
+            out += "{ ";
+            break;
+        case 1:
+            out += "if (a > " + std::to_string(level) + ") { ";
+            break;
+        default:
+            out += "while (a < " + i + ") { ";
+        }
+    }
+
+    out += "a = ";
+    out.append(depth, '(');
+    out += "a + " + i;
+    for (int level = 0; level < depth; ++level)
+        out += ") * 2";
+    out += ";";
+
+    out.append(depth, '}');
+    out += "\n}\n";
+}
+
+// declarations and uses of names a few hundred characters long
+void identifiers(std::string &out, std::size_t n)
+{
+    const std::string name = "a_rather_long_and_descriptive_variable_name_" + std::string(200, 'x') + "_" +
+                             std::to_string(n);
+    const std::string other = "AnotherLongIdentifierWithMixedCase" + std::string(100, 'Y') + std::to_string(n);
+
+    out += "var " + name + " = " + std::to_string(n) + ";\n";
+    out += "var " + other + " = " + name + ";\n";
+    out += name + " = " + other + " + " + name + ";\n";
+}
+
+// string literals of all lengths, concatenated and passed to calls
+void strings(std::string &out, std::size_t n)
+{
+    const std::string i = std::to_string(n);
+
+    out += "var s" + i + " = \"a short one\" + \"" + std::string(n % 200, 's') + "\";\n";
+    out += "print \"" + std::string(500, 'q') + " " + i + "\";\n";
+    out += "s" + i + " = s" + i + " + \"line\" + \"" + i + "\" + \"\" + \"tab\tand more text\";\n";
+}
+
+// single line and block comments around a little code
+void comments(std::string &out, std::size_t n)
+{
+    const std::string i = std::to_string(n);
+
+    out += "// comment " + i + ": " + std::string(100, '-') + "\n";
+    out += "/* a block comment\n   over several lines " + i + "\n   " + std::string(200, '*') + " */\n";
+    out += "var c" + i + " = " + i + "; // and one at the end of a line\n";
+    out += "//\n// " + std::string(60, '=') + "\n//\n";
+}
+
+// long expressions with all the operators, calls, properties and indexes
+void expressions(std::string &out, std::size_t n)
+{
+    const std::string i = std::to_string(n);
+
+    out += "var e" + i + " = (1 + 2 * 3 - 4 / 5) * -" + i + " + f(a, b.c, d[" + i + "]) - g(h(i(j)));\n";
+    out += "e" + i + " = a.b.c.d(1, 2, 3)[0] + !x == (y != z) and p < q or r >= s and t <= u;\n";
+    out += "print [1, 2, 3, " + i + ", \"four\", nil, true, false][" + i + "] + " + i + ".5 * 0.25;\n";
+    out += "obj.field = list[" + i + "] = value * value + (value - 1) / (value + 1);\n";
+}
+
+const std::map<std::string, Unit> corpora = {
+    {"nesting", nesting}, {"identifiers", identifiers}, {"strings", strings},
+    {"comments", comments}, {"expressions", expressions},
+};
+
+// ---- counting the AST ----
+
+// statements and expressions. of a lazy body only what is parsed so far counts, nothing right after the parser
+class NodeCounter final : public ExprVisitor, public StmtVisitor
+{
+  public:
+    std::uint64_t count(const Statement::stmt_vec &stmts)
+    {
+        for (const Statement::stmt_ptr &stmt : stmts)
+            statement(stmt.get());
+        return _nodes;
+    }
+
+    void visitAssignExpr(const AssignExpression &expr) override
+    {
+        expression(expr._value.get());
+    }
+    void visitBinaryExpr(const BinaryExpression &expr) override
+    {
+        expression(expr._left.get());
+        expression(expr._right.get());
+    }
+    void visitCallExpr(const CallExpression &expr) override
+    {
+        expression(expr._callee.get());
+        for (const Expression::expr_ptr &arg : expr._args)
+            expression(arg.get());
+    }
+    void visitGetExpr(const GetExpression &expr) override
+    {
+        expression(expr._object.get());
+    }
+    void visitGroupingExpr(const GroupingExpression &expr) override
+    {
+        expression(expr._expression.get());
+    }
+    void visitIndexExpr(const IndexExpression &expr) override
+    {
+        expression(expr._object.get());
+        expression(expr._index.get());
+    }
+    void visitIndexAssignExpr(const IndexAssignExpression &expr) override
+    {
+        expression(expr._object.get());
+        expression(expr._index.get());
+        expression(expr._value.get());
+    }
+    void visitListExpr(const ListExpression &expr) override
+    {
+        for (const Expression::expr_ptr &element : expr._elements)
+            expression(element.get());
+    }
+    void visitLiteralExpr(const LiteralExpression &) override
+    {
+    }
+    void visitLogicalExpr(const LogicalExpression &expr) override
+    {
+        expression(expr._left.get());
+        expression(expr._right.get());
+    }
+    void visitSetExpr(const SetExpression &expr) override
+    {
+        expression(expr._object.get());
+        expression(expr._value.get());
+    }
+    void visitSuperExpr(const SuperExpression &) override
+    {
+    }
+    void visitThisExpr(const ThisExpression &) override
+    {
+    }
+    void visitUnaryExpr(const UnaryExpression &expr) override
+    {
+        expression(expr._right.get());
+    }
+    void visitVarExpr(const VarExpression &) override
+    {
+    }
+
+    // the parser doesn't fuse, these only come from the Fuser
+    void visitIncrementExpr(const IncrementExpression &) override
+    {
+    }
+    void visitCompareConstExpr(const CompareConstExpression &) override
+    {
+    }
+    void visitAssignBinaryExpr(const AssignBinaryExpression &expr) override
+    {
+        expression(expr._right.get());
+    }
+    void visitLiteralCallExpr(const LiteralCallExpression &expr) override
+    {
+        expression(expr._call.get());
+    }
+
+    void visitIfStmt(const IfStatement &stmt) override
+    {
+        expression(stmt._condition.get());
+        statement(stmt._thenBranch.get());
+        statement(stmt._elseBranch.get());
+    }
+    void visitBlockStmt(const BlockStatement &stmt) override
+    {
+        count(stmt._statements);
+    }
+    void visitClassStmt(const ClassStatement &stmt) override
+    {
+        expression(stmt._superclass.get());
+        for (const ClassStatement::function_ptr &method : stmt._methods)
+            statement(method.get());
+    }
+    void visitExpressionStmt(const ExpressionStatement &stmt) override
+    {
+        expression(stmt._expr.get());
+    }
+    void visitFunctionStatement(const FunctionStatement &stmt) override
+    {
+        count(stmt._lazy ? stmt._lazy->body : stmt._body);
+    }
+    void visitVarStmt(const VarStatement &stmt) override
+    {
+        expression(stmt._initializer.get());
+    }
+    void visitPrintStmt(const PrintStatement &stmt) override
+    {
+        expression(stmt._expr.get());
+    }
+    void visitReturnStmt(const ReturnStatement &stmt) override
+    {
+        expression(stmt._value.get());
+    }
+    void visitWhileStmt(const WhileStatement &stmt) override
+    {
+        expression(stmt._condition.get());
+        statement(stmt._body.get());
+    }
+    void visitForStmt(const ForStatement &stmt) override
+    {
+        statement(stmt._initializer.get());
+        expression(stmt._condition.get());
+        expression(stmt._increment.get());
+        statement(stmt._body.get());
+    }
+    void visitBreakStmt(const BreakStatement &) override
+    {
+    }
+
+  private:
+    void expression(const Expression *expr)
+    {
+        if (!expr)
+            return;
+        ++_nodes;
+        expr->accept(*this);
+    }
+
+    void statement(const Statement *stmt)
+    {
+        if (!stmt)
+            return;
+        ++_nodes;
+        stmt->accept(*this);
+    }
+
+    std::uint64_t _nodes{0};
+};
+
+// ---- measuring ----
+
+struct Options
+{
+    std::vector<std::size_t> sizes{1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024};
+    double minTime{500}; // ms each measurement is repeated for at least
+    bool lazy{false};
+    std::string dump; // the corpora are written there, if set
+    std::vector<std::string> names;
+};
+
+struct Run
+{
+    double seconds;
+    std::uint64_t bytes; // allocated
+};
+
+// the median of runs repeated for at least minTime (and three times), prepare isn't timed
+template <typename Prepare, typename Measured> Run repeat(double minTime, Prepare prepare, Measured measured)
+{
+    using clock = std::chrono::steady_clock;
+
+    std::vector<Run> runs;
+    double total = 0;
+    while (runs.size() < 3 || total < minTime / 1000)
+    {
+        prepare();
+
+        const std::uint64_t before = bench::allocatedBytes();
+        const clock::time_point start = clock::now();
+        measured();
+        const clock::time_point end = clock::now();
+
+        runs.push_back({std::chrono::duration<double>(end - start).count(), bench::allocatedBytes() - before});
+        total += runs.back().seconds;
+    }
+
+    std::sort(runs.begin(), runs.end(), [](const Run &a, const Run &b) { return a.seconds < b.seconds; });
+    return runs[runs.size() / 2];
+}
+
+std::size_t parseSize(std::string text)
+{
+    std::size_t factor = 1;
+    if (!text.empty() && (text.back() == 'K' || text.back() == 'k'))
+        factor = 1024;
+    else if (!text.empty() && (text.back() == 'M' || text.back() == 'm'))
+        factor = 1024 * 1024;
+    if (factor > 1)
+        text.pop_back();
+
+    return std::stoul(text) * factor;
+}
+
+std::string sizeName(std::size_t size)
+{
+    if (size >= 1024 * 1024 && size % (1024 * 1024) == 0)
+        return std::to_string(size / (1024 * 1024)) + "M";
+    if (size >= 1024 && size % 1024 == 0)
+        return std::to_string(size / 1024) + "K";
+    return std::to_string(size);
+}
+
+int usage()
+{
+    std::cout << "Usage: lox-frontend [--sizes=1K,64K,1M,16M] [--min-time=ms] [--lazy] [--dump=dir] [corpus...]"
+              << std::endl;
+    return EXIT_FAILURE;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+
+        if (arg.starts_with("--sizes="))
+        {
+            options.sizes.clear();
+            std::istringstream list{arg.substr(std::string{"--sizes="}.size())};
+            for (std::string size; std::getline(list, size, ',');)
+                options.sizes.push_back(parseSize(size));
+        }
+        else if (arg.starts_with("--min-time="))
+            options.minTime = std::stod(arg.substr(std::string{"--min-time="}.size()));
+        else if (arg == "--lazy")
+            options.lazy = true;
+        else if (arg.starts_with("--dump="))
+            options.dump = arg.substr(std::string{"--dump="}.size());
+        else if (!arg.starts_with("--") && corpora.contains(arg))
+            options.names.push_back(arg);
+        else
+            return usage();
+    }
+
+    std::cout << std::left << std::setw(13) << "corpus" << std::right << std::setw(6) << "size" << std::setw(11)
+              << "tokens" << std::setw(11) << "nodes" << std::setw(11) << "scan MB/s" << std::setw(13)
+              << "scan Mtok/s" << std::setw(12) << "scan B/tok" << std::setw(14) << "parse Mtok/s" << std::setw(16)
+              << "parse Mnodes/s" << std::setw(13) << "parse B/tok" << "\n"
+              << std::fixed;
+
+    for (const auto &[name, unit] : corpora)
+    {
+        const bool chosen =
+            options.names.empty() || std::find(options.names.begin(), options.names.end(), name) != options.names.end();
+        if (!chosen)
+            continue;
+
+        for (const std::size_t size : options.sizes)
+        {
+            const std::string source = generate(unit, size);
+            if (!options.dump.empty())
+                std::ofstream{std::filesystem::path{options.dump} / (name + "-" + sizeName(size) + ".lox")} << source;
+
+            std::ostringstream diagnostics;
+            ErrorHandler errors{diagnostics};
+
+            Scanner::tokenlist_t tokens;
+            const Run scan = repeat(options.minTime, [&] { tokens.clear(); }, [&] {
+                Scanner scanner{source, errors};
+                tokens = scanner.scanTokens();
+            });
+
+            // the parser takes the tokens, every run gets a copy of them
+            Scanner::tokenlist_t copy;
+            Statement::stmt_vec stmts;
+            const Run parse = repeat(options.minTime, [&] {
+                stmts.clear();
+                copy = Scanner::tokenlist_t{tokens}; // tokens can't be assigned, only built
+            }, [&] {
+                Parser parser{copy, errors, options.lazy};
+                stmts = parser.parse();
+            });
+
+            if (errors.hadError())
+            {
+                std::cerr << "The " << name << " corpus doesn't compile:\n" << diagnostics.str().substr(0, 1000);
+                return EXIT_FAILURE;
+            }
+
+            const auto count = static_cast<double>(tokens.size());
+            const auto nodes = static_cast<double>(NodeCounter{}.count(stmts));
+            const double megabytes = static_cast<double>(source.size()) / (1024 * 1024);
+
+            std::cout << std::left << std::setw(13) << name << std::right << std::setw(6) << sizeName(size)
+                      << std::setw(11) << tokens.size() << std::setw(11) << static_cast<std::uint64_t>(nodes)
+                      << std::setprecision(1) << std::setw(11) << megabytes / scan.seconds << std::setprecision(2)
+                      << std::setw(13) << count / scan.seconds / 1e6 << std::setprecision(1) << std::setw(12)
+                      << static_cast<double>(scan.bytes) / count << std::setprecision(2) << std::setw(14)
+                      << count / parse.seconds / 1e6 << std::setw(16) << nodes / parse.seconds / 1e6
+                      << std::setprecision(1) << std::setw(13) << static_cast<double>(parse.bytes) / count
+                      << std::endl;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
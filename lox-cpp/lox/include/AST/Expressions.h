@@ -4,10 +4,58 @@
 #include "../scanning/Token.h"
 #include "../types/LoxLiterals.h"
 #include "Visitor.h"
+#include <cstdint>
 #include <vector>
 
 namespace lox
 {
+class Environment;
+class LoxFunction;
+class Shape;
+
+// inline cache for variables that can only be globals (see Resolver and Environment::getGlobal)
+struct GlobalCache
+{
+    std::uint64_t stamp{0}; // stamp of the global scope, changes whenever a new global is defined
+    Environment *owner{nullptr};
+    std::uint32_t slot{0};
+};
+
+// inline cache for property accesses, keyed on the shape of the instance (see Shape.h).
+// it remembers up to 4 shapes (polymorphic), any further shape always takes the slow path
+struct PropertyCache
+{
+    struct Entry
+    {
+        std::uint32_t shapeId{0}; // 0 -> unused / not found
+        std::uint32_t slot{0};    // slot of the field
+        const LoxFunction *method{nullptr}; // or the method of the instance's class
+        std::shared_ptr<Shape> transition{}; // only for SetExpression: the shape after adding the field
+    };
+
+    static constexpr std::size_t capacity = 4;
+    Entry entries[capacity];
+    std::size_t size{0};
+
+    Entry *find(std::uint32_t shapeId)
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            if (entries[i].shapeId == shapeId)
+                return &entries[i];
+        }
+        return nullptr;
+    }
+
+    // once all entries are taken, the last one keeps getting replaced
+    Entry &add(Entry entry)
+    {
+        Entry &target = entries[size < capacity ? size++ : capacity - 1];
+        target = std::move(entry);
+        return target;
+    }
+};
+
 // abstract Expression class
 class Expression
 {
@@ -30,6 +78,9 @@ class AssignExpression final : public Expression
     const Token _name;
     Expression::expr_ptr _value;
 
+    mutable bool _isGlobal{false}; // set by the Resolver
+    mutable GlobalCache _cache;
+
     void accept(ExprVisitor &visitor) const override
     {
         visitor.visitAssignExpr(*this);
@@ -43,6 +94,8 @@ class BinaryExpression final : public Expression
     const Token _operator;
     expr_ptr _right;
 
+    mutable bool _unchecked{false}; // set by TypeInference, both operands are proven numbers
+
     BinaryExpression(expr_ptr &left, const Token &op, expr_ptr &right)
         : _left{std::move(left)}, _operator{op}, _right{std::move(right)}
     {
@@ -57,14 +110,12 @@ class BinaryExpression final : public Expression
 class CallExpression final : public Expression
 {
   public:
-    CallExpression(Expression::expr_ptr &callee, const Token &paren, Expression::expr_vec &args)
-        : _callee{std::move(callee)}, _paren{paren}, _args{std::move(args)}
-    {
-    }
+    CallExpression(Expression::expr_ptr &callee, const Token &paren, Expression::expr_vec &args);
 
     Expression::expr_ptr _callee;
     const Token _paren;
-    const Expression::expr_vec _args;
+    Expression::expr_vec _args;
+    const GetExpression *_method; // if the callee is a property (obj.method()), calls it without binding
 
     void accept(ExprVisitor &visitor) const override
     {
@@ -72,6 +123,23 @@ class CallExpression final : public Expression
     }
 };
 
+class GetExpression final : public Expression
+{
+  public:
+    GetExpression(expr_ptr &object, const Token &name) : _object{std::move(object)}, _name{name}
+    {
+    }
+
+    expr_ptr _object;
+    const Token _name;
+    mutable PropertyCache _cache;
+
+    void accept(ExprVisitor &visitor) const override
+    {
+        visitor.visitGetExpr(*this);
+    }
+};
+
 class GroupingExpression final : public Expression
 {
   public:
@@ -87,6 +155,59 @@ class GroupingExpression final : public Expression
     }
 };
 
+class IndexExpression final : public Expression
+{
+  public:
+    IndexExpression(expr_ptr &object, const Token &bracket, expr_ptr &index)
+        : _object{std::move(object)}, _bracket{bracket}, _index{std::move(index)}
+    {
+    }
+
+    expr_ptr _object;
+    const Token _bracket; // for error reports
+    expr_ptr _index;
+
+    void accept(ExprVisitor &visitor) const override
+    {
+        visitor.visitIndexExpr(*this);
+    }
+};
+
+// list[index] = value
+class IndexAssignExpression final : public Expression
+{
+  public:
+    IndexAssignExpression(expr_ptr &object, const Token &bracket, expr_ptr &index, expr_ptr &value)
+        : _object{std::move(object)}, _bracket{bracket}, _index{std::move(index)}, _value{std::move(value)}
+    {
+    }
+
+    expr_ptr _object;
+    const Token _bracket;
+    expr_ptr _index;
+    expr_ptr _value;
+
+    void accept(ExprVisitor &visitor) const override
+    {
+        visitor.visitIndexAssignExpr(*this);
+    }
+};
+
+class ListExpression final : public Expression
+{
+  public:
+    ListExpression(expr_vec &elements) : _elements{std::move(elements)}
+    {
+    }
+
+    expr_vec _elements;
+
+    void accept(ExprVisitor &visitor) const override
+    {
+        visitor.visitListExpr(*this);
+    }
+};
+
 class LiteralExpression final : public Expression
 {
   public:
@@ -120,6 +241,56 @@ class LogicalExpression final : public Expression
     }
 };
 
+class SetExpression final : public Expression
+{
+  public:
+    SetExpression(expr_ptr &object, const Token &name, expr_ptr &value)
+        : _object{std::move(object)}, _name{name}, _value{std::move(value)}
+    {
+    }
+
+    expr_ptr _object;
+    const Token _name;
+    expr_ptr _value;
+    mutable PropertyCache _cache;
+
+    void accept(ExprVisitor &visitor) const override
+    {
+        visitor.visitSetExpr(*this);
+    }
+};
+
+class SuperExpression final : public Expression
+{
+  public:
+    SuperExpression(const Token &keyword, const Token &method) : _keyword{keyword}, _method{method}
+    {
+    }
+
+    const Token _keyword;
+    const Token _method;
+
+    void accept(ExprVisitor &visitor) const override
+    {
+        visitor.visitSuperExpr(*this);
+    }
+};
+
+class ThisExpression final : public Expression
+{
+  public:
+    ThisExpression(const Token &keyword) : _keyword{keyword}
+    {
+    }
+
+    const Token _keyword;
+
+    void accept(ExprVisitor &visitor) const override
+    {
+        visitor.visitThisExpr(*this);
+    }
+};
+
 class UnaryExpression final : public Expression
 {
   public:
@@ -130,6 +301,8 @@ class UnaryExpression final : public Expression
     const Token _operator;
     expr_ptr _right;
 
+    mutable bool _unchecked{false}; // set by TypeInference, the operand is a proven number
+
     void accept(ExprVisitor &visitor) const override
     {
         visitor.visitUnaryExpr(*this);
@@ -145,12 +318,111 @@ class VarExpression final : public Expression
 
     const Token _name;
 
+    mutable bool _isGlobal{false}; // set by the Resolver
+    mutable GlobalCache _cache;
+
     void accept(ExprVisitor &visitor) const override
     {
         visitor.visitVarExpr(*this);
     }
 };
 
+// ---- fused expressions, the Fuser rewrites common patterns into them after the static passes ----
+
+// name = name + constant, name = name - constant
+class IncrementExpression final : public Expression
+{
+  public:
+    IncrementExpression(const Token &name, const Token &op, const literal_t &delta, bool isGlobal, bool isUnchecked)
+        : _name{name}, _operator{op}, _delta{delta}, _isGlobal{isGlobal}, _unchecked{isUnchecked}
+    {
+    }
+
+    const Token _name;
+    const Token _operator;
+    const literal_t _delta;
+
+    mutable bool _isGlobal; // set by the Resolver
+    mutable GlobalCache _cache;
+    mutable bool _unchecked; // set by TypeInference, the variable is a proven number
+
+    void accept(ExprVisitor &visitor) const override
+    {
+        visitor.visitIncrementExpr(*this);
+    }
+};
+
+// name < constant, name == constant etc.
+class CompareConstExpression final : public Expression
+{
+  public:
+    CompareConstExpression(const Token &name, const Token &op, const literal_t &constant, bool isGlobal,
+                           bool isUnchecked)
+        : _name{name}, _operator{op}, _constant{constant}, _isGlobal{isGlobal}, _unchecked{isUnchecked}
+    {
+    }
+
+    const Token _name;
+    const Token _operator;
+    const literal_t _constant;
+
+    mutable bool _isGlobal; // set by the Resolver
+    mutable GlobalCache _cache;
+    mutable bool _unchecked; // set by TypeInference, the variable is a proven number
+
+    void accept(ExprVisitor &visitor) const override
+    {
+        visitor.visitCompareConstExpr(*this);
+    }
+};
+
+// name = name op right, the right operand has no side effects (so the variable can be updated in place)
+class AssignBinaryExpression final : public Expression
+{
+  public:
+    AssignBinaryExpression(const Token &name, const Token &op, expr_ptr &right, bool isGlobal, bool isUnchecked)
+        : _name{name}, _operator{op}, _right{std::move(right)}, _isGlobal{isGlobal}, _unchecked{isUnchecked}
+    {
+    }
+
+    const Token _name;
+    const Token _operator;
+    expr_ptr _right;
+
+    mutable bool _isGlobal; // set by the Resolver
+    mutable GlobalCache _cache;
+    mutable bool _unchecked; // set by TypeInference, both operands are proven numbers
+
+    void accept(ExprVisitor &visitor) const override
+    {
+        visitor.visitAssignBinaryExpr(*this);
+    }
+};
+
+// a call whose arguments are all literals, they are evaluated once up front
+class LiteralCallExpression final : public Expression
+{
+  public:
+    LiteralCallExpression(const std::shared_ptr<CallExpression> &call, std::vector<literal_t> &args)
+        : _call{call}, _args{std::move(args)}
+    {
+    }
+
+    const std::shared_ptr<CallExpression> _call;
+    const std::vector<literal_t> _args;
+
+    void accept(ExprVisitor &visitor) const override
+    {
+        visitor.visitLiteralCallExpr(*this);
+    }
+};
+
+inline CallExpression::CallExpression(Expression::expr_ptr &callee, const Token &paren, Expression::expr_vec &args)
+    : _callee{std::move(callee)}, _paren{paren}, _args{std::move(args)},
+      _method{dynamic_cast<const GetExpression *>(_callee.get())}
+{
+}
+
 } // namespace lox
 
 #endif
@@ -3,9 +3,13 @@
 
 #include "Expressions.h"
 #include <memory>
+#include <string>
+#include <unordered_set>
 
 namespace lox
 {
+class Program;
+
 // abstract Statement class
 class Statement
 {
@@ -52,6 +56,26 @@ class BlockStatement final : public Statement
     }
 };
 
+class ClassStatement final : public Statement
+{
+  public:
+    using function_ptr = std::shared_ptr<FunctionStatement>;
+
+    ClassStatement(const Token &name, std::shared_ptr<VarExpression> &superclass, std::vector<function_ptr> &methods)
+        : _name{name}, _superclass{std::move(superclass)}, _methods{std::move(methods)}
+    {
+    }
+
+    const Token _name;
+    const std::shared_ptr<VarExpression> _superclass; // optional
+    const std::vector<function_ptr> _methods;
+
+    void accept(StmtVisitor &visitor) const override
+    {
+        visitor.visitClassStmt(*this);
+    }
+};
+
 class ExpressionStatement final : public Statement
 {
   public:
@@ -67,6 +91,22 @@ class ExpressionStatement final : public Statement
     };
 };
 
+// body of a function that the parser only brace matched (lazy mode), it's parsed and analyzed on the first call
+struct LazyBody
+{
+    enum class State
+    {
+        UNPARSED,
+        PARSED,
+        FAILED // syntax errors, reported on the first call
+    };
+
+    std::vector<Token> tokens;                // between the braces, ends with Eof
+    std::unordered_set<std::string> assigned; // every name that could be assigned in the body, for the static passes
+    State state{State::UNPARSED};
+    Statement::stmt_vec body;
+};
+
 class FunctionStatement final : public Statement
 {
   public:
@@ -75,9 +115,15 @@ class FunctionStatement final : public Statement
     {
     }
 
+    FunctionStatement(const Token &name, std::vector<Token> &params, const std::shared_ptr<LazyBody> &lazy)
+        : _name{name}, _params{std::move(params)}, _lazy{lazy}
+    {
+    }
+
     const Token _name;
     const std::vector<Token> _params;
-    const Statement::stmt_vec _body;
+    const Statement::stmt_vec _body;          // empty, if the body is lazy
+    const std::shared_ptr<LazyBody> _lazy{}; // shared by the copies the Interpreter makes
 
     void accept(StmtVisitor &visitor) const override
     {
@@ -150,11 +196,60 @@ class WhileStatement final : public Statement
     }
 };
 
-// literally an empty class, the accept method is the only important part ^^
+// the reduce(op) acc clause of a parallel for loop. every chunk of the iterations accumulates into a partial
+// result of its own, starting at the identity of op, the partials are combined into acc in chunk order
+struct Reduction
+{
+    Token op;          // + or *
+    Token accumulator;
+
+    mutable bool isGlobal{false}; // set by the Resolver
+    mutable GlobalCache cache{};
+    mutable std::shared_ptr<const Program> body{}; // the loop body on its own, compiled for the chunks on the first run
+};
+
+// for loops in the canonical counter shape: for (var i = start; i < bound; i = i + step), the step is an int.
+// the Interpreter runs them as a native counted loop as long as i stays an int, other for loops are desugared
+// into a WhileStatement by the Parser.
+// parallel for loops (with a reduction) count upwards and run their iterations as tasks, see LoxTask.h
+class ForStatement final : public Statement
+{
+  public:
+    ForStatement(std::shared_ptr<VarStatement> &initializer, Expression::expr_ptr &condition,
+                 Expression::expr_ptr &increment, Statement::stmt_ptr &body, const Expression::expr_ptr &bound,
+                 const Token &comparison, std::int64_t step, const std::shared_ptr<Reduction> &reduction = nullptr)
+        : _initializer{std::move(initializer)}, _condition{std::move(condition)}, _increment{std::move(increment)},
+          _body{std::move(body)}, _bound{bound}, _comparison{comparison}, _step{step}, _reduction{reduction}
+    {
+    }
+
+    const std::shared_ptr<VarStatement> _initializer; // declares the counter
+    Expression::expr_ptr _condition;
+    Expression::expr_ptr _increment;
+    Statement::stmt_ptr _body;
+
+    // the pieces of the condition and increment, for the native loop
+    const Expression::expr_ptr _bound; // right operand of the condition
+    const Token _comparison;           // <, <=, > or >=
+    const std::int64_t _step;
+
+    const std::shared_ptr<Reduction> _reduction; // nullptr, unless it's a parallel loop
+
+    void accept(StmtVisitor &visitor) const override
+    {
+        visitor.visitForStmt(*this);
+    }
+};
+
+// the accept method is the important part, the keyword is only there for error messages
 class BreakStatement final : public Statement
 {
   public:
-    BreakStatement() = default;
+    explicit BreakStatement(const Token &keyword) : _keyword{keyword}
+    {
+    }
+
+    const Token _keyword;
 
     void accept(StmtVisitor &visitor) const override
     {
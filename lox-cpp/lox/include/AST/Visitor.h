@@ -7,21 +7,34 @@ namespace lox
 class AssignExpression;
 class BinaryExpression;
 class CallExpression;
+class GetExpression;
 class GroupingExpression;
+class IndexExpression;
+class IndexAssignExpression;
+class ListExpression;
 class LiteralExpression;
 class LogicalExpression;
+class SetExpression;
+class SuperExpression;
+class ThisExpression;
 class UnaryExpression;
 class VarExpression;
+class IncrementExpression;
+class CompareConstExpression;
+class AssignBinaryExpression;
+class LiteralCallExpression;
 
 // statements
 class IfStatement;
 class BlockStatement;
+class ClassStatement;
 class ExpressionStatement;
 class FunctionStatement;
 class VarStatement;
 class PrintStatement;
 class ReturnStatement;
 class WhileStatement;
+class ForStatement;
 class BreakStatement;
 
 // abstract
@@ -33,11 +46,24 @@ class ExprVisitor
     virtual void visitAssignExpr(const AssignExpression &) = 0;
     virtual void visitBinaryExpr(const BinaryExpression &) = 0;
     virtual void visitCallExpr(const CallExpression &) = 0;
+    virtual void visitGetExpr(const GetExpression &) = 0;
     virtual void visitGroupingExpr(const GroupingExpression &) = 0;
+    virtual void visitIndexExpr(const IndexExpression &) = 0;
+    virtual void visitIndexAssignExpr(const IndexAssignExpression &) = 0;
+    virtual void visitListExpr(const ListExpression &) = 0;
     virtual void visitLiteralExpr(const LiteralExpression &) = 0;
     virtual void visitLogicalExpr(const LogicalExpression &) = 0;
+    virtual void visitSetExpr(const SetExpression &) = 0;
+    virtual void visitSuperExpr(const SuperExpression &) = 0;
+    virtual void visitThisExpr(const ThisExpression &) = 0;
     virtual void visitUnaryExpr(const UnaryExpression &) = 0;
     virtual void visitVarExpr(const VarExpression &) = 0;
+
+    // fused expressions
+    virtual void visitIncrementExpr(const IncrementExpression &) = 0;
+    virtual void visitCompareConstExpr(const CompareConstExpression &) = 0;
+    virtual void visitAssignBinaryExpr(const AssignBinaryExpression &) = 0;
+    virtual void visitLiteralCallExpr(const LiteralCallExpression &) = 0;
 };
 
 // abstract
@@ -48,12 +74,14 @@ class StmtVisitor
 
     virtual void visitIfStmt(const IfStatement &) = 0;
     virtual void visitBlockStmt(const BlockStatement &) = 0;
+    virtual void visitClassStmt(const ClassStatement &) = 0;
     virtual void visitExpressionStmt(const ExpressionStatement &) = 0;
     virtual void visitFunctionStatement(const FunctionStatement &) = 0;
     virtual void visitVarStmt(const VarStatement &) = 0;
     virtual void visitPrintStmt(const PrintStatement &) = 0;
     virtual void visitReturnStmt(const ReturnStatement &) = 0;
     virtual void visitWhileStmt(const WhileStatement &) = 0;
+    virtual void visitForStmt(const ForStatement &) = 0;
     virtual void visitBreakStmt(const BreakStatement &) = 0;
 };
 
@@ -0,0 +1,36 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "Lox.h"
+#include <cstddef>
+#include <string>
+
+namespace lox
+{
+
+// runs every .lox file below a directory (--batch), each one in its own isolate on a ThreadPool.
+// the output and errors of every script are captured and printed in the order of the paths, as if the scripts
+// had run one after another
+class Batch
+{
+  public:
+    struct Options
+    {
+        std::string directory;
+        std::size_t threads{0}; // 0 is one thread per core
+    };
+
+    Batch(const Options &options, const Lox::Options &loxOptions) : _options{options}, _loxOptions{loxOptions}
+    {
+    }
+
+    int run(); // EXIT_FAILURE, if any script failed
+
+  private:
+    const Options _options;
+    const Lox::Options _loxOptions;
+};
+
+} // namespace lox
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef ERRORHANDLER_H
 #define ERRORHANDLER_H
 
+#include <cstddef>
+#include <ostream>
 #include <string>
 
 namespace lox
@@ -8,14 +10,44 @@ namespace lox
 class Token;
 class LoxRuntimeError;
 
+// the diagnostics of one isolate (see Lox): reports errors to its stream and remembers that they happened
 class ErrorHandler
 {
   public:
-    static void error(int line, const std::string &message);
-    static void error(const Token &token, const std::string &message);
-    static void runtimeError(const LoxRuntimeError &e);
+    explicit ErrorHandler(std::ostream &err) : _err{err}
+    {
+    }
 
-    static void report(int line, const std::string &where, const std::string &message);
+    void error(int line, const std::string &message);
+    void error(const Token &token, const std::string &message);
+    void runtimeError(const LoxRuntimeError &e);
+
+    void report(int line, const std::string &where, const std::string &message);
+
+    // errors found before running (scanning, parsing, resolving)
+    std::size_t errorCount() const
+    {
+        return _errorCount;
+    }
+    bool hadError() const
+    {
+        return _errorCount > 0;
+    }
+    bool hadRuntimeError() const
+    {
+        return _hadRuntimeError;
+    }
+    void reset();
+
+    std::ostream &stream()
+    {
+        return _err;
+    }
+
+  private:
+    std::ostream &_err;
+    std::size_t _errorCount{0};
+    bool _hadRuntimeError{false};
 };
 
 } // namespace lox
@@ -0,0 +1,170 @@
+#ifndef EVENTLOOP_H
+#define EVENTLOOP_H
+
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// epoll and eventfd are linux only, elsewhere the async natives report that they aren't supported (see LoxFuture)
+#ifdef __linux__
+
+namespace lox
+{
+
+// single threaded scheduler for c++20 coroutines doing non-blocking i/o, on top of epoll (linux).
+// a job runs on the loop thread until it waits for a file descriptor, a timer or its next turn (yield), the loop
+// runs the other jobs meanwhile. jobs can be started from any thread, everything else is for the jobs themselves
+class EventLoop
+{
+  public:
+    using clock = std::chrono::steady_clock;
+
+    // a coroutine that runs on the loop, nobody waits for it: it hands out its results itself (see LoxFuture)
+    class Job
+    {
+      public:
+        struct promise_type
+        {
+            Job get_return_object()
+            {
+                return Job{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            std::suspend_always initial_suspend() noexcept // until the loop takes it
+            {
+                return {};
+            }
+            std::suspend_never final_suspend() noexcept // frees itself, once it's done
+            {
+                return {};
+            }
+
+            void return_void()
+            {
+            }
+            void unhandled_exception()
+            {
+                std::terminate(); // jobs catch their errors, there is nobody to rethrow to
+            }
+        };
+
+      private:
+        friend class EventLoop;
+
+        explicit Job(std::coroutine_handle<> handle) : _handle{handle}
+        {
+        }
+
+        std::coroutine_handle<> _handle;
+    };
+
+    EventLoop();
+    ~EventLoop(); // jobs that are still waiting get destroyed
+
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    void start(Job job);
+
+    // ---- awaitables for the jobs ----
+
+    // co_await readable(fd): waits until fd can be read without blocking and is true.
+    // false right away for descriptors epoll can't watch (regular files), reading those never blocks for long
+    struct Readable
+    {
+        EventLoop &loop;
+        int fd;
+        bool polled{false};
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            return polled = loop.poll(fd, handle);
+        }
+        bool await_resume() const noexcept
+        {
+            return polled;
+        }
+    };
+
+    struct Sleep
+    {
+        EventLoop &loop;
+        clock::time_point until;
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            loop._timers.emplace(until, handle);
+        }
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+    // lets the other jobs that are ready run first, for long running jobs
+    struct Yield
+    {
+        EventLoop &loop;
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            loop._ready.push_back(handle);
+        }
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+    Readable readable(int fd)
+    {
+        return Readable{*this, fd};
+    }
+    Sleep sleep(std::chrono::milliseconds duration)
+    {
+        return Sleep{*this, clock::now() + duration};
+    }
+    Yield yield()
+    {
+        return Yield{*this};
+    }
+
+  private:
+    void run(); // the loop thread
+    void wake();
+    bool poll(int fd, std::coroutine_handle<> handle);
+
+    const int _epoll;
+    const int _wakeup; // eventfd, for jobs started from other threads and for stopping
+
+    std::mutex _mutex; // guards the started jobs and stopping, the rest belongs to the loop thread
+    std::vector<std::coroutine_handle<>> _started;
+    bool _stopping{false};
+
+    std::deque<std::coroutine_handle<>> _ready;
+    std::multimap<clock::time_point, std::coroutine_handle<>> _timers;
+    std::unordered_map<int, std::coroutine_handle<>> _polling; // one job per descriptor
+
+    std::thread _thread;
+};
+
+} // namespace lox
+
+#endif
+#endif
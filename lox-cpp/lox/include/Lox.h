@@ -1,25 +1,90 @@
 #ifndef LOX_H
 #define LOX_H
 
+#include "AST/Statements.h"
+#include "ErrorHandler.h"
+#include "Program.h"
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace lox
 {
+class Environment;
 class Interpreter;
 
+// one isolate: its own globals, output and errors. separate isolates share no mutable state,
+// they can run on separate threads (a single one isn't thread-safe)
 class Lox
 {
   public:
-    void runFile(const std::string &&filename);
+    struct Options
+    {
+        bool report{false};      // print what the optimization passes did to stderr
+        bool lazy{false};        // parse the bodies of top level functions on their first call
+        bool cache{false};       // keep the analyzed AST of scripts in an AstCache file
+        bool lineProfile{false}; // hits and time per line of a script to stderr (built with LOX_LINE_PROFILE)
+        std::string cacheDir;    // where the cache files go, next to the script if empty
+    };
+
+    Lox();
+    explicit Lox(const Options &options);
+    Lox(const Options &options, std::ostream &out, std::ostream &err); // print goes to out, errors to err
+    ~Lox();
+
+    bool runFile(const std::string &&filename); // false, if the file couldn't be read or had errors
     void runPrompt();
     void run(const std::string &sourceCode);
 
+    // embedding: a script is compiled once and executed many times, on this isolate and others (one per thread).
+    // the inputs of a program are globals defined before it runs, its results are globals read afterwards
+    std::shared_ptr<const Program> prepare(const std::string &sourceCode); // nullptr, if it has errors
+    bool execute(const std::shared_ptr<const Program> &program);          // false on a runtime error
+    void define(const std::string &name, const literal_t &value);
+    std::optional<literal_t> global(const std::string &name) const;
+
+    // for the Server: every script starts with a copy of the global scope at the time of the snapshot
+    void snapshotGlobals();
+    void restoreGlobals();
+
     // indicates, if any errors were found
-    static bool hadError;
-    static bool hadRuntimeError;
+    bool hadError() const
+    {
+        return _errors.hadError();
+    }
+    bool hadRuntimeError() const
+    {
+        return _errors.hadRuntimeError();
+    }
+    void resetErrors()
+    {
+        _errors.reset();
+    }
 
   private:
-    static Interpreter _interpreter;
+    void run(const std::string &sourceCode, const std::string &script); // the script's path is for the AstCache
+    // empty, if there were errors. shared: other code runs against the same global scope (see TypeInference.h)
+    Statement::stmt_vec compile(const std::string &sourceCode, bool shared);
+    bool sharedGlobals() const
+    {
+        return _prompt || _ranCode;
+    }
+
+    Options _options;
+    std::ostream &_out;
+    std::ostream &_err;
+    ErrorHandler _errors;
+
+    // the copies of the programs executed here, the globals can still hold functions that live in them.
+    // they go back to their programs after the interpreter is gone
+    std::vector<std::pair<std::shared_ptr<const Program>, std::unique_ptr<Program::Instance>>> _instances;
+    std::unique_ptr<Interpreter> _interpreter;
+    std::shared_ptr<const Environment> _snapshot;
+    bool _prompt{false};
+    bool _ranCode{false}; // the globals can hold functions of earlier code
 };
 
 } // namespace lox
@@ -0,0 +1,131 @@
+#ifndef LOXNATIVE_H
+#define LOXNATIVE_H
+
+/*
+ * stable C interface for native extension modules, loaded at runtime with loadNative("libfoo.so").
+ *
+ * a module exports the entry point
+ *
+ *     int lox_native_init(const lox_native_api *api)
+ *
+ * which defines its functions with api->define(api->registry, "name", arity, function, userdata)
+ * and returns 0 on success. example:
+ *
+ *     static lox_value twice(const lox_value *args, int argc, void *userdata)
+ *     {
+ *         if (args[0].type != LOX_NUMBER)
+ *             return lox_error("Expected a number.");
+ *         return lox_number(args[0].as.number * 2);
+ *     }
+ *
+ *     int lox_native_init(const lox_native_api *api)
+ *     {
+ *         if (api->version != LOX_NATIVE_API_VERSION)
+ *             return 1;
+ *         api->define(api->registry, "twice", 1, twice, NULL);
+ *         return 0;
+ *     }
+ *
+ * strings passed to a function are only valid during the call. strings returned from a function
+ * (LOX_STRING and LOX_ERROR) are copied by the interpreter right after the call returns.
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define LOX_NATIVE_API_VERSION 1
+#define LOX_NATIVE_ENTRY_POINT "lox_native_init"
+
+typedef enum lox_value_type
+{
+    LOX_NIL,
+    LOX_BOOL,
+    LOX_NUMBER,
+    LOX_STRING,
+    LOX_ERROR /* only as a return value: raises a runtime error with the string as message */
+} lox_value_type;
+
+typedef struct lox_value
+{
+    lox_value_type type;
+    union {
+        int boolean;
+        double number;
+        struct
+        {
+            const char *chars;
+            size_t length;
+        } string;
+    } as;
+} lox_value;
+
+typedef lox_value (*lox_native_fn)(const lox_value *args, int argc, void *userdata);
+
+typedef struct lox_registry lox_registry; /* opaque */
+
+typedef struct lox_native_api
+{
+    int version;
+    lox_registry *registry;
+    void (*define)(lox_registry *registry, const char *name, int arity, lox_native_fn function, void *userdata);
+} lox_native_api;
+
+typedef int (*lox_native_init_fn)(const lox_native_api *api);
+
+/* ---- helpers for building values ---- */
+
+static inline lox_value lox_nil(void)
+{
+    lox_value v;
+    v.type = LOX_NIL;
+    v.as.number = 0;
+    return v;
+}
+
+static inline lox_value lox_bool(int b)
+{
+    lox_value v;
+    v.type = LOX_BOOL;
+    v.as.boolean = b;
+    return v;
+}
+
+static inline lox_value lox_number(double n)
+{
+    lox_value v;
+    v.type = LOX_NUMBER;
+    v.as.number = n;
+    return v;
+}
+
+static inline lox_value lox_string(const char *chars, size_t length)
+{
+    lox_value v;
+    v.type = LOX_STRING;
+    v.as.string.chars = chars;
+    v.as.string.length = length;
+    return v;
+}
+
+static inline lox_value lox_error(const char *message)
+{
+    lox_value v;
+    size_t length = 0;
+    while (message[length])
+        ++length;
+
+    v.type = LOX_ERROR;
+    v.as.string.chars = message;
+    v.as.string.length = length;
+    return v;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
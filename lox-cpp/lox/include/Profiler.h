@@ -0,0 +1,137 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace lox
+{
+
+// sampling profiler for lox code (--profile). a timer signal on cpu time (SIGPROF) interrupts whichever thread is
+// running and records its lox call stack: the functions with the lines they were called from. the samples are
+// folded into one line per distinct stack (frame;frame;frame count), the input of flamegraph tools.
+// the signal handler can't allocate, it counts the stacks in a table that is allocated up front.
+// one profiler at a time
+class Profiler
+{
+  public:
+    explicit Profiler(int hertz = 997); // starts sampling, an odd rate doesn't run in step with the program
+    ~Profiler();
+
+    Profiler(const Profiler &) = delete;
+    Profiler &operator=(const Profiler &) = delete;
+
+    void write(std::ostream &out); // stops sampling and writes the folded stacks
+
+    std::uint64_t samples() const
+    {
+        return _samples.load(std::memory_order_relaxed);
+    }
+    std::uint64_t dropped() const // stacks that didn't fit into the table anymore
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+    static constexpr int maxDepth = 64;        // deeper calls are left out of the samples
+    static constexpr std::size_t maxName = 64; // with the terminating zero
+
+    // a call on the lox call stack of this thread, for the lifetime of the object.
+    // only a relaxed load while nothing is profiled
+    class Frame
+    {
+      public:
+        Frame(const std::string &name, int line)
+        {
+            if (!_sampling.load(std::memory_order_relaxed))
+                return;
+
+            const int depth = _stack.depth.load(std::memory_order_relaxed);
+            if (depth < maxDepth)
+                _stack.calls[depth] = Call{&name, line};
+
+            std::atomic_signal_fence(std::memory_order_release); // the call is there before the handler sees it
+            _stack.depth.store(depth + 1, std::memory_order_relaxed);
+            _pushed = true;
+        }
+
+        ~Frame()
+        {
+            if (_pushed)
+                _stack.depth.store(_stack.depth.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        }
+
+        Frame(const Frame &) = delete;
+        Frame &operator=(const Frame &) = delete;
+
+      private:
+        bool _pushed{false};
+    };
+
+  private:
+    struct Call
+    {
+        const std::string *name; // into the AST of the caller, only alive while the call runs
+        int line;                // of the call site
+    };
+
+    // only written by its thread, and read by the handler interrupting that thread
+    struct Stack
+    {
+        Call calls[maxDepth];
+        std::atomic<int> depth; // zero to begin with, may be deeper than maxDepth
+    };
+
+    // a call of a recorded stack, the name is copied into the name table. the ASTs of tasks and parallel loops
+    // are gone by the time the profile is written
+    struct Sampled
+    {
+        int name; // index into the name table, -1 if it was full
+        int line;
+    };
+
+    struct Slot
+    {
+        std::atomic<std::uint64_t> hash{0}; // 0 is a free slot
+        std::atomic<bool> ready{false};     // the calls are written
+        std::atomic<std::uint64_t> count{0};
+        int depth{0};
+        Sampled calls[maxDepth];
+    };
+
+    struct Name
+    {
+        std::atomic<std::uint64_t> hash{0}; // 0 is a free entry
+        std::atomic<bool> ready{false};     // the text is written
+        char text[maxName];                 // longer names are cut off
+    };
+
+    static constexpr std::size_t tableSize = 4096; // distinct stacks, a power of two
+    static constexpr std::size_t namesSize = 1024; // distinct function names, a power of two
+
+    static void sample(int); // the signal handler
+    void record(const Stack &stack);
+    int intern(const std::string &name);
+    void stop();
+
+    inline static std::atomic<bool> _sampling{false};
+    inline static std::atomic<Profiler *> _active{nullptr};
+    inline static std::atomic<int> _handlers{0}; // running right now
+    inline static thread_local Stack _stack;
+
+    const std::unique_ptr<Slot[]> _slots;
+    const std::unique_ptr<Name[]> _names;
+    std::atomic<std::uint64_t> _samples{0};
+    std::atomic<std::uint64_t> _dropped{0};
+    timer_t _timer{};
+    bool _running{true};
+};
+
+} // namespace lox
+
+#endif
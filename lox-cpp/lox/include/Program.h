@@ -0,0 +1,70 @@
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include "AST/Statements.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace lox
+{
+
+// a compiled script (see Lox::prepare), it can be executed any number of times from any number of threads.
+// the nodes of the AST keep runtime caches, so every isolate runs on a copy of its own. the copies are built from
+// the AstCache image of the analyzed AST and handed out again once the isolate lets go of them, so only the first
+// executions pay for building one
+class Program
+{
+  public:
+    Program(std::string image, std::uint64_t hash, bool lazy)
+        : _image{std::move(image)}, _hash{hash}, _lazy{lazy}
+    {
+    }
+
+    Program(const Program &) = delete;
+    Program &operator=(const Program &) = delete;
+
+    // a copy of the AST for one isolate, it goes back to the program when this is destroyed
+    class Instance
+    {
+      public:
+        Instance(const Program &program, Statement::stmt_vec stmts) : _program{program}, _stmts{std::move(stmts)}
+        {
+        }
+
+        ~Instance()
+        {
+            _program.release(std::move(_stmts));
+        }
+
+        Instance(const Instance &) = delete;
+        Instance &operator=(const Instance &) = delete;
+
+        const Statement::stmt_vec &statements() const
+        {
+            return _stmts;
+        }
+
+      private:
+        const Program &_program;
+        Statement::stmt_vec _stmts;
+    };
+
+    std::unique_ptr<Instance> instantiate() const;
+
+  private:
+    void release(Statement::stmt_vec stmts) const;
+
+    const std::string _image;
+    const std::uint64_t _hash;
+    const bool _lazy;
+
+    mutable std::mutex _mutex;
+    mutable std::vector<Statement::stmt_vec> _idle; // copies that no execution is using
+};
+
+} // namespace lox
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "Lox.h"
+#include <string>
+
+namespace lox
+{
+
+// keeps an interpreter alive and runs the scripts submitted over a unix domain socket (--serve).
+// every script gets a fresh global scope that starts with the natives and the definitions of the prelude (its
+// lists, maps and instances are copied for every script).
+//
+// protocol, all integers in native byte order:
+//   client -> server: u32 length, the source code
+//   server -> client: frames of u8 kind, u32 length, payload while the script runs.
+//                     kind 'o' is stdout, 'e' stderr and the last frame 'x' carries the i32 exit status
+class Server
+{
+  public:
+    struct Options
+    {
+        std::string socketPath;
+        std::string prelude; // script that runs once before serving, optional
+        bool fork{false};    // run every script in a forked child, which shares the prelude copy-on-write
+    };
+
+    Server(const Options &options, Lox &lox) : _options{options}, _lox{lox}
+    {
+    }
+
+    int serve(); // only returns on errors
+
+    // the client side, prints the output of the script and returns its exit status
+    static int submit(const std::string &socketPath, const std::string &script);
+
+  private:
+    void handle(int connection);
+    int runScript(int connection, const std::string &sourceCode);
+
+    const Options _options;
+    Lox &_lox;
+};
+
+} // namespace lox
+
+#endif
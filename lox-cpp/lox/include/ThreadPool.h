@@ -0,0 +1,97 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lox
+{
+
+// work-stealing pool: every worker has its own queue, takes the newest task of it and steals the oldest task of
+// another queue when it runs dry. tasks submitted by a worker go to its own queue, the others are spread evenly.
+// a worker that blocks inside a task (see block) is replaced by a spare thread until it continues
+class ThreadPool
+{
+  public:
+    using task_t = std::function<void()>;
+
+    explicit ThreadPool(std::size_t threads = 0); // 0 is one thread per core
+    ~ThreadPool();                                // runs the queued tasks to the end
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void submit(task_t task);
+
+    // runs one queued task on the calling thread, a thread waiting for a task can help instead of blocking
+    bool runPending();
+
+    // waits on the calling thread (joining a task, a full or empty channel). on a worker, a spare thread runs the
+    // queued tasks meanwhile, so the ones it waits for can't be stuck behind it
+    template <typename F> void block(F &&wait)
+    {
+        if (currentPool() != this)
+        {
+            wait();
+            return;
+        }
+
+        enterBlocking();
+        const struct Leave
+        {
+            ThreadPool &pool;
+            ~Leave()
+            {
+                pool.leaveBlocking();
+            }
+        } leave{*this};
+
+        wait();
+    }
+
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+  private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<task_t> tasks;
+    };
+
+    static constexpr std::size_t spare = SIZE_MAX; // index of threads without a queue of their own
+
+    static const ThreadPool *currentPool(); // of the worker running on this thread
+
+    void work(std::size_t index);
+    bool take(std::size_t index, task_t &task); // own queue first, then steal from the others
+    void enterBlocking();
+    void leaveBlocking();
+
+    const std::size_t _size; // workers, not counting the spares
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _workers;
+    std::atomic<std::size_t> _next{0}; // queue for the next task from outside
+
+    std::mutex _mutex; // guards the sleeping, the queues have their own
+    std::condition_variable _wake;
+    std::atomic<std::size_t> _queued{0};
+    bool _stopping{false};
+    std::size_t _running{0}; // threads that aren't blocked, spares included
+    std::size_t _spares{0};
+    std::condition_variable _sparesDone;
+};
+
+} // namespace lox
+
+#endif
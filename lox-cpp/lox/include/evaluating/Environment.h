@@ -1,13 +1,15 @@
 #ifndef ENVIRONMENT_H
 #define ENVIRONMENT_H
 
+#include "../types/HashIndex.h"
 #include "../types/LoxLiterals.h"
 #include <memory>
-#include <unordered_map>
+#include <vector>
 
 namespace lox
 {
 class Token;
+struct GlobalCache;
 
 // the place here all the variables (associations) are saved for one scope each
 
@@ -18,12 +20,50 @@ class Environment
     Environment(environment_ptr enclosing = nullptr);
 
     void define(const std::string &name, const literal_t &value);
+    void define(const Token &name, const literal_t &value);
+    void defineAll(const Environment &other); // the variables of the other scope, without its enclosing ones
     void assign(const Token &name, const literal_t &value);
     literal_t get(const Token &name);
+    const literal_t *value(const std::string &name) const; // nullptr, if it isn't defined in this scope
+    environment_ptr enclosing() const
+    {
+        return _enclosing;
+    }
+
+    // calls f(name, value) for every variable of this scope, in the order they were defined
+    template <typename F> void forEach(F &&f) const
+    {
+        for (const Binding &binding : _values)
+            f(binding.name, binding.value);
+    }
+
+    // lookups for variables that can only be globals, the cache is reused as long as
+    // no new variable has been defined in this scope since it was filled
+    const literal_t &getGlobal(const Token &name, GlobalCache &cache);
+    void assignGlobal(const Token &name, const literal_t &value, GlobalCache &cache);
+
+    // the variable itself, for in-place updates. the reference is only valid until the next define
+    literal_t &lookup(const Token &name);
+    literal_t &lookupGlobal(const Token &name, GlobalCache &cache);
 
   private:
+    struct Binding
+    {
+        std::size_t hash;
+        std::string name;
+        literal_t value;
+    };
+
+    // most scopes (function calls, blocks) only hold a few variables, scanning them is faster than hashing
+    static constexpr std::size_t linearScanLimit = 8;
+
+    void define(std::size_t hash, const std::string &name, const literal_t &value);
+    std::uint32_t find(std::size_t hash, const std::string &name) const; // HashIndex::npos if not in this scope
+
     environment_ptr _enclosing; // [optional] holds the environment from the outer scope
-    std::unordered_map<std::string, literal_t> _values;
+    std::vector<Binding> _values;
+    HashIndex _index; // only built when the scope outgrows the linear scan
+    std::uint64_t _stamp; // unique per environment, renewed whenever a new variable is defined
 };
 
 } // namespace lox
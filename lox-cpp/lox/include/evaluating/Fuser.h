@@ -0,0 +1,47 @@
+#ifndef FUSER_H
+#define FUSER_H
+
+#include "Rewriter.h"
+#include <array>
+
+namespace lox
+{
+
+// rewrites common patterns into fused expressions (superinstructions), that evaluate in one visit and update
+// variables in place. runs after the Resolver and TypeInference, the fused nodes take over their marks
+class Fuser : public Rewriter
+{
+  public:
+    enum class Pattern
+    {
+        INCREMENT,      // i = i + 1
+        COMPARE_CONST,  // i < 10
+        ASSIGN_BINARY,  // x = x * y
+        LITERAL_CALL,   // f(1, "a")
+        COUNT
+    };
+
+    void fuse(const Statement::stmt_vec &stmts)
+    {
+        rewrite(stmts);
+    }
+
+    std::size_t hits(Pattern pattern) const
+    {
+        return _hits[static_cast<std::size_t>(pattern)];
+    }
+    static const char *name(Pattern pattern);
+
+    void visitAssignExpr(const AssignExpression &expr) override;
+    void visitBinaryExpr(const BinaryExpression &expr) override;
+    void visitCallExpr(const CallExpression &expr) override;
+
+  private:
+    void replaceWith(Pattern pattern, Expression::expr_ptr fused);
+
+    std::array<std::size_t, static_cast<std::size_t>(Pattern::COUNT)> _hits{};
+};
+
+} // namespace lox
+
+#endif
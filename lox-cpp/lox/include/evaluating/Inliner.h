@@ -0,0 +1,66 @@
+#ifndef INLINER_H
+#define INLINER_H
+
+#include "Rewriter.h"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace lox
+{
+
+// replaces calls to small functions with their body, runs after the Resolver and before TypeInference.
+// a function is inlined, if
+//  - it's declared at the top level and its name is never declared again at the top level or assigned anywhere,
+//    so the global always holds this function (calls through a local of the same name aren't global)
+//  - its body is a single return of a side effect free expression without calls (inlined calls to functions
+//    declared before are fine), so it can't recurse
+//  - the body stays within the size budget
+// call sites need matching arity and side effect free arguments, literals and variables can be used by the body any
+// number of times, other ones exactly once. calls that can run before the declaration (textually earlier) are
+// left alone
+class Inliner : public Rewriter
+{
+  public:
+    static constexpr std::size_t maxBodySize = 16; // nodes of the returned expression
+
+    void inlineCalls(const Statement::stmt_vec &stmts); // needs the whole program
+
+    std::size_t inlinedCalls() const;
+    const std::vector<std::pair<std::string, std::size_t>> &inlinedCallsPerFunction() const
+    {
+        return _inlined;
+    }
+
+    // statements
+    void visitFunctionStatement(const FunctionStatement &) override;
+
+    // expressions
+    void visitAssignExpr(const AssignExpression &expr) override;
+    void visitCallExpr(const CallExpression &expr) override;
+
+  private:
+    struct Candidate
+    {
+        const FunctionStatement *function;
+        const Expression *body;         // the returned expression
+        std::vector<std::size_t> uses;  // per parameter
+        std::vector<bool> skippable;    // per parameter, a use of it may be skipped by and/or
+        std::size_t index;              // in _inlined
+    };
+
+    void addCandidate(const FunctionStatement &function);
+
+    bool _collecting{false}; // first run, only collects the assigned globals
+    std::unordered_map<std::string, std::size_t> _declarations; // top level names -> count
+    std::unordered_set<std::string> _assigned;                  // globals that are assigned somewhere
+
+    std::unordered_map<std::string, Candidate> _candidates;
+    std::vector<std::pair<std::string, std::size_t>> _inlined; // function -> inlined call sites
+};
+
+} // namespace lox
+
+#endif
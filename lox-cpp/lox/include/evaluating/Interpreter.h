@@ -6,63 +6,133 @@
 #include "../AST/Visitor.h"
 #include "../types/LoxLiterals.h"
 #include "Environment.h"
+#include "LineProfile.h"
+#include <memory>
+#include <ostream>
+#include <vector>
 
 namespace lox
 {
+class ErrorHandler;
+class Program;
 
 class Interpreter : public ExprVisitor, public StmtVisitor
 {
   public:
-    Interpreter();
+    Interpreter(std::ostream &out, ErrorHandler &errors); // print writes to out, errors are reported to errors
     Environment::environment_ptr globals() const
     {
         return _globals;
     }
 
-    void interpret(const Statement::stmt_vec &stmts);
+    // the program the statements belong to is built from them, if a task needs it (see LoxTask.h)
+    void interpret(const Statement::stmt_vec &stmts, std::shared_ptr<const Program> program = nullptr);
+    // only runs the top level function and class declarations, the statements stay the running program
+    void declare(const Statement::stmt_vec &stmts, std::shared_ptr<const Program> program);
+
+    // the running program and its top level statements, nullptr when nothing is running
+    std::shared_ptr<const Program> program();
+    const Statement::stmt_vec *statements() const
+    {
+        return _running;
+    }
+
+    std::ostream &out()
+    {
+        return _out;
+    }
+    ErrorHandler &errors()
+    {
+        return _errors;
+    }
+
+#ifdef LOX_LINE_PROFILE
+    void profileLines(LineProfile *profile) // nullptr stops
+    {
+        _lineProfile = profile;
+    }
+#endif
+
+    void resetGlobals(const Environment &snapshot); // a fresh global scope with the variables of the snapshot
     std::string toString();
     std::string toString(const literal_t &val);
 
     // evaluating statements
     void visitIfStmt(const IfStatement &) override;
     void visitBlockStmt(const BlockStatement &) override;
+    void visitClassStmt(const ClassStatement &) override;
     void visitExpressionStmt(const ExpressionStatement &) override;
     void visitFunctionStatement(const FunctionStatement &) override;
     void visitVarStmt(const VarStatement &) override;
     void visitPrintStmt(const PrintStatement &) override;
     void visitReturnStmt(const ReturnStatement &) override;
     void visitWhileStmt(const WhileStatement &) override;
+    void visitForStmt(const ForStatement &) override;
     void visitBreakStmt(const BreakStatement &) override;
 
     // evaluating expression
     void visitAssignExpr(const AssignExpression &expr) override;
     void visitBinaryExpr(const BinaryExpression &expr) override;
     void visitCallExpr(const CallExpression &expr) override;
+    void visitGetExpr(const GetExpression &expr) override;
     void visitGroupingExpr(const GroupingExpression &expr) override;
+    void visitIndexExpr(const IndexExpression &expr) override;
+    void visitIndexAssignExpr(const IndexAssignExpression &expr) override;
+    void visitListExpr(const ListExpression &expr) override;
     void visitLiteralExpr(const LiteralExpression &expr) override;
     void visitLogicalExpr(const LogicalExpression &expr) override;
+    void visitSetExpr(const SetExpression &expr) override;
+    void visitSuperExpr(const SuperExpression &expr) override;
+    void visitThisExpr(const ThisExpression &expr) override;
     void visitUnaryExpr(const UnaryExpression &expr) override;
     void visitVarExpr(const VarExpression &expr) override;
 
+    // fused expressions
+    void visitIncrementExpr(const IncrementExpression &expr) override;
+    void visitCompareConstExpr(const CompareConstExpression &expr) override;
+    void visitAssignBinaryExpr(const AssignBinaryExpression &expr) override;
+    void visitLiteralCallExpr(const LiteralCallExpression &expr) override;
+
     void executeBlock(const Statement::stmt_vec &stmts,
                       Environment::environment_ptr environment); // for block statements
 
+    // parses and analyzes the body of a lazy function on the first call, throws if it has syntax errors
+    const Statement::stmt_vec &lazyBody(const FunctionStatement &function);
+
   protected:
     // evaluate expression and return result (literal)
     literal_t getLiteral(const Expression::expr_ptr &expr);
 
-    void evaluatePlus(const literal_t &left, const literal_t &right, const Token &op);
+    literal_t &variable(const Token &name, bool isGlobal, GlobalCache &cache);
+    literal_t evaluateBinary(const Token &op, const literal_t &left, const literal_t &right, bool unchecked);
+    void evaluateCall(const CallExpression &expr, const std::vector<literal_t> *literalArgs);
+    std::vector<literal_t> evaluateArguments(const CallExpression &expr);
+    void runCountedLoop(const ForStatement &stmt);
+    void runParallelLoop(const ForStatement &stmt);
+    literal_t evaluatePlus(const literal_t &left, const literal_t &right, const Token &op);
     bool isTruthy(const literal_t &lit);
     bool isEqual(const literal_t &a, const literal_t &b);
 
     // error handling / type checking
     void checkOperand(const Token &op, const literal_t &operand);
     void checkOperand(const Token &op, const literal_t &left, const literal_t &right);
+    std::size_t checkIndex(const Token &bracket, const LoxList &list, const literal_t &index);
+    void checkKey(const Token &bracket, const literal_t &key);
+    void checkArity(const LoxCallable &callee, const std::vector<literal_t> &args, const Token &paren);
+    std::shared_ptr<LoxInstance> checkInstance(const Token &name, const literal_t &object, const char *message);
 
   private:
+    std::ostream &_out;
+    ErrorHandler &_errors;
+    const Statement::stmt_vec *_running{nullptr};
+    std::shared_ptr<const Program> _program;
     Environment::environment_ptr _globals;
     Environment::environment_ptr _environment; // for saving variables
     literal_t _resultingLiteral;
+    std::vector<const void *> _printing; // the lists and maps toString is in, to find the cycles
+#ifdef LOX_LINE_PROFILE
+    LineProfile *_lineProfile{nullptr};
+#endif
 };
 } // namespace lox
 
@@ -0,0 +1,92 @@
+#ifndef LINEPROFILE_H
+#define LINEPROFILE_H
+
+#include "../AST/Statements.h"
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace lox
+{
+
+// exact hits and time per source line (--line-profile), taken around every statement the Interpreter executes.
+// a statement's time leaves out the statements nested in it (loop bodies, called functions), so the lines add up
+// to the whole run. only built in with LOX_LINE_PROFILE defined, otherwise LOX_PROFILE_STATEMENT is empty and the
+// Interpreter doesn't even know about it
+class LineProfile
+{
+    struct Entry; // of one statement, see below
+
+  public:
+    using clock = std::chrono::steady_clock;
+
+    // the source with hits, time and share of every line, then the top lines by time
+    void report(std::ostream &out, const std::string &source, std::size_t top = 10) const;
+
+    // times one statement for the lifetime of the object, nothing if there is no profile
+    class Scope
+    {
+      public:
+        Scope(LineProfile *profile, const Statement &stmt) : _profile{profile}
+        {
+            if (!profile)
+                return;
+
+            _entry = &profile->entry(stmt);
+            _outer = std::exchange(profile->_current, this);
+            _start = clock::now();
+        }
+
+        ~Scope()
+        {
+            if (!_profile)
+                return;
+
+            const clock::duration elapsed = clock::now() - _start;
+            ++_entry->hits;
+            _entry->time += elapsed - _nested;
+
+            if (_outer)
+                _outer->_nested += elapsed;
+            _profile->_current = _outer;
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+      private:
+        friend class LineProfile;
+
+        LineProfile *const _profile;
+        Entry *_entry{nullptr};
+        Scope *_outer{nullptr};
+        clock::time_point _start;
+        clock::duration _nested{0};
+    };
+
+  private:
+    struct Entry
+    {
+        int line{0};
+        std::uint64_t hits{0};
+        clock::duration time{0};
+    };
+
+    Entry &entry(const Statement &stmt); // the line is looked up on the first hit
+
+    std::unordered_map<const Statement *, Entry> _entries;
+    Scope *_current{nullptr}; // innermost statement running
+};
+
+} // namespace lox
+
+#ifdef LOX_LINE_PROFILE
+#define LOX_PROFILE_STATEMENT(stmt) const lox::LineProfile::Scope lineProfileScope{_lineProfile, stmt}
+#else
+#define LOX_PROFILE_STATEMENT(stmt)
+#endif
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include "../AST/Expressions.h"
+#include "../AST/Statements.h"
+#include "../AST/Visitor.h"
+#include "../ErrorHandler.h"
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace lox
+{
+
+// static pass that runs before interpreting.
+// every scope created at runtime (blocks, function calls) mirrors a scope in the source code, so a variable
+// that isn't declared in any enclosing scope can only be a global -> those accesses get marked and the
+// Interpreter looks them up directly in the global slot table instead of walking the scope chain.
+// it also checks that the body of a parallel for doesn't change anything declared outside of it, besides
+// accumulating into the reduction. the iterations run at the same time on copies, other changes would be lost
+class Resolver : public ExprVisitor, public StmtVisitor
+{
+  public:
+    explicit Resolver(ErrorHandler &errors) : _errors{errors}
+    {
+    }
+
+    void resolve(const Statement::stmt_vec &stmts);
+
+    // statements
+    void visitIfStmt(const IfStatement &) override;
+    void visitBlockStmt(const BlockStatement &) override;
+    void visitClassStmt(const ClassStatement &) override;
+    void visitExpressionStmt(const ExpressionStatement &) override;
+    void visitFunctionStatement(const FunctionStatement &) override;
+    void visitVarStmt(const VarStatement &) override;
+    void visitPrintStmt(const PrintStatement &) override;
+    void visitReturnStmt(const ReturnStatement &) override;
+    void visitWhileStmt(const WhileStatement &) override;
+    void visitForStmt(const ForStatement &) override;
+    void visitBreakStmt(const BreakStatement &) override;
+
+    // expressions
+    void visitAssignExpr(const AssignExpression &expr) override;
+    void visitBinaryExpr(const BinaryExpression &expr) override;
+    void visitCallExpr(const CallExpression &expr) override;
+    void visitGetExpr(const GetExpression &expr) override;
+    void visitGroupingExpr(const GroupingExpression &expr) override;
+    void visitIndexExpr(const IndexExpression &expr) override;
+    void visitIndexAssignExpr(const IndexAssignExpression &expr) override;
+    void visitListExpr(const ListExpression &expr) override;
+    void visitLiteralExpr(const LiteralExpression &expr) override;
+    void visitLogicalExpr(const LogicalExpression &expr) override;
+    void visitSetExpr(const SetExpression &expr) override;
+    void visitSuperExpr(const SuperExpression &expr) override;
+    void visitThisExpr(const ThisExpression &expr) override;
+    void visitUnaryExpr(const UnaryExpression &expr) override;
+    void visitVarExpr(const VarExpression &expr) override;
+
+    // fused expressions
+    void visitIncrementExpr(const IncrementExpression &expr) override;
+    void visitCompareConstExpr(const CompareConstExpression &expr) override;
+    void visitAssignBinaryExpr(const AssignBinaryExpression &expr) override;
+    void visitLiteralCallExpr(const LiteralCallExpression &expr) override;
+
+  protected:
+    void resolve(const Statement::stmt_ptr &stmt);
+    void resolve(const Expression::expr_ptr &expr);
+
+    // a scope knows all of its declarations in advance, no matter where they appear in the block
+    void beginScope(const Statement::stmt_vec &stmts, const std::vector<Token> &params = {});
+    void endScope();
+    bool isGlobal(const Token &name) const;
+
+    // ---- parallel loops ----
+    bool isParallelLocal(const Token &name) const; // declared inside the body of the innermost parallel loop
+    bool isAccumulator(const Token &name) const;
+    void checkParallelAssign(const Token &name);
+    void checkParallelChange(const Expression::expr_ptr &object); // object.field = ..., list[index] = ..., push(list)
+
+  private:
+    enum class ClassType
+    {
+        NONE,
+        CLASS,
+        SUBCLASS
+    };
+
+    enum class FunctionType
+    {
+        NONE,
+        FUNCTION,
+        METHOD,
+        INITIALIZER
+    };
+
+    void resolveFunction(const FunctionStatement &function, FunctionType type);
+
+    // the innermost parallel loop the resolver is in
+    struct Parallel
+    {
+        const Reduction *reduction{nullptr}; // nullptr outside of parallel loops
+        std::size_t base{0};                 // first scope of the body
+        int loops{0};                        // loops inside the body, breaks leave those
+        int functions{0};                    // functions inside the body, returns leave those
+        bool ownClass{false};                // 'this' belongs to a class declared inside the body
+    };
+
+    std::vector<std::unordered_set<std::string>> _scopes; // empty at the top level (global scope)
+    ClassType _currentClass{ClassType::NONE};
+    FunctionType _currentFunction{FunctionType::NONE};
+    Parallel _parallel;
+    const Expression *_accumulating{nullptr}; // the acc in acc = acc op value, the one read of acc that's allowed
+    ErrorHandler &_errors;
+};
+
+} // namespace lox
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef REWRITER_H
+#define REWRITER_H
+
+#include "../AST/Expressions.h"
+#include "../AST/Statements.h"
+#include "../AST/Visitor.h"
+
+namespace lox
+{
+
+// base for the passes that replace expressions in the AST (Inliner, Fuser).
+// the visit methods walk every child, passes override the ones they are interested in and call replaceWith()
+// to swap the visited expression for another one
+class Rewriter : public ExprVisitor, public StmtVisitor
+{
+  public:
+    void rewrite(const Statement::stmt_vec &stmts);
+
+    // statements
+    void visitIfStmt(const IfStatement &) override;
+    void visitBlockStmt(const BlockStatement &) override;
+    void visitClassStmt(const ClassStatement &) override;
+    void visitExpressionStmt(const ExpressionStatement &) override;
+    void visitFunctionStatement(const FunctionStatement &) override;
+    void visitVarStmt(const VarStatement &) override;
+    void visitPrintStmt(const PrintStatement &) override;
+    void visitReturnStmt(const ReturnStatement &) override;
+    void visitWhileStmt(const WhileStatement &) override;
+    void visitForStmt(const ForStatement &) override;
+    void visitBreakStmt(const BreakStatement &) override;
+
+    // expressions
+    void visitAssignExpr(const AssignExpression &expr) override;
+    void visitBinaryExpr(const BinaryExpression &expr) override;
+    void visitCallExpr(const CallExpression &expr) override;
+    void visitGetExpr(const GetExpression &expr) override;
+    void visitGroupingExpr(const GroupingExpression &expr) override;
+    void visitIndexExpr(const IndexExpression &expr) override;
+    void visitIndexAssignExpr(const IndexAssignExpression &expr) override;
+    void visitListExpr(const ListExpression &expr) override;
+    void visitLiteralExpr(const LiteralExpression &expr) override;
+    void visitLogicalExpr(const LogicalExpression &expr) override;
+    void visitSetExpr(const SetExpression &expr) override;
+    void visitSuperExpr(const SuperExpression &expr) override;
+    void visitThisExpr(const ThisExpression &expr) override;
+    void visitUnaryExpr(const UnaryExpression &expr) override;
+    void visitVarExpr(const VarExpression &expr) override;
+
+    // fused expressions
+    void visitIncrementExpr(const IncrementExpression &expr) override;
+    void visitCompareConstExpr(const CompareConstExpression &expr) override;
+    void visitAssignBinaryExpr(const AssignBinaryExpression &expr) override;
+    void visitLiteralCallExpr(const LiteralCallExpression &expr) override;
+
+  protected:
+    void rewrite(const Statement::stmt_ptr &stmt);
+    void rewrite(const Expression::expr_ptr &expr); // rewrites the children first, then maybe the node itself
+    void replaceWith(Expression::expr_ptr replacement);
+
+    // the expression that is being visited, take a copy before rewriting the children
+    const Expression::expr_ptr &current() const
+    {
+        return _current;
+    }
+
+    static bool hasNoSideEffects(const Expression &expr);
+
+  private:
+    Expression::expr_ptr _current;
+    Expression::expr_ptr _replacement; // set by the visit methods, if the visited node should be replaced
+};
+
+} // namespace lox
+
+#endif
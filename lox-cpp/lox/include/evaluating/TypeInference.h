@@ -0,0 +1,123 @@
+#ifndef TYPEINFERENCE_H
+#define TYPEINFERENCE_H
+
+#include "../AST/Expressions.h"
+#include "../AST/Statements.h"
+#include "../AST/Visitor.h"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace lox
+{
+
+// flow-sensitive static pass that runs after the Resolver.
+// it tracks the types of local variables through the program (joining them after branches and iterating loops
+// to a fixpoint) and marks every arithmetic/comparison whose operands are proven numbers as _unchecked,
+// the Interpreter evaluates those without the dynamic type checks.
+// only variables that can't change behind the pass' back are tracked: names that are assigned from inside a
+// function they aren't declared in are never tracked, and variables of enclosing functions are unknown.
+// globals are only tracked when no other code runs against the same global scope: the functions of an earlier
+// line of the prompt (or of the prelude of a server) could assign them
+class TypeInference : public ExprVisitor, public StmtVisitor
+{
+  public:
+    explicit TypeInference(bool trackGlobals = true) : _trackGlobals{trackGlobals}
+    {
+    }
+
+    void infer(const Statement::stmt_vec &stmts);
+
+    std::size_t removedChecks() const;
+    std::size_t totalChecks() const
+    {
+        return _checks.size();
+    }
+
+    // statements
+    void visitIfStmt(const IfStatement &) override;
+    void visitBlockStmt(const BlockStatement &) override;
+    void visitClassStmt(const ClassStatement &) override;
+    void visitExpressionStmt(const ExpressionStatement &) override;
+    void visitFunctionStatement(const FunctionStatement &) override;
+    void visitVarStmt(const VarStatement &) override;
+    void visitPrintStmt(const PrintStatement &) override;
+    void visitReturnStmt(const ReturnStatement &) override;
+    void visitWhileStmt(const WhileStatement &) override;
+    void visitForStmt(const ForStatement &) override;
+    void visitBreakStmt(const BreakStatement &) override;
+
+    // expressions
+    void visitAssignExpr(const AssignExpression &expr) override;
+    void visitBinaryExpr(const BinaryExpression &expr) override;
+    void visitCallExpr(const CallExpression &expr) override;
+    void visitGetExpr(const GetExpression &expr) override;
+    void visitGroupingExpr(const GroupingExpression &expr) override;
+    void visitIndexExpr(const IndexExpression &expr) override;
+    void visitIndexAssignExpr(const IndexAssignExpression &expr) override;
+    void visitListExpr(const ListExpression &expr) override;
+    void visitLiteralExpr(const LiteralExpression &expr) override;
+    void visitLogicalExpr(const LogicalExpression &expr) override;
+    void visitSetExpr(const SetExpression &expr) override;
+    void visitSuperExpr(const SuperExpression &expr) override;
+    void visitThisExpr(const ThisExpression &expr) override;
+    void visitUnaryExpr(const UnaryExpression &expr) override;
+    void visitVarExpr(const VarExpression &expr) override;
+
+    // fused expressions
+    void visitIncrementExpr(const IncrementExpression &expr) override;
+    void visitCompareConstExpr(const CompareConstExpression &expr) override;
+    void visitAssignBinaryExpr(const AssignBinaryExpression &expr) override;
+    void visitLiteralCallExpr(const LiteralCallExpression &expr) override;
+
+  private:
+    enum class StaticType
+    {
+        NIL,
+        BOOL,
+        NUMBER,
+        STRING,
+        UNKNOWN
+    };
+
+    using state_t = std::vector<StaticType>; // type of every variable (by id) at the current point
+
+    static StaticType typeOf(const literal_t &value);
+    static StaticType join(StaticType a, StaticType b);
+    static state_t join(const state_t &a, const state_t &b);
+    void merge(const state_t &other, bool otherDead); // joins another path into the current one
+
+    void analyze(const Statement::stmt_vec &stmts);
+    void analyze(const Statement::stmt_ptr &stmt);
+    StaticType infer(const Expression::expr_ptr &expr);
+    StaticType binaryType(const Expression &expr, bool &unchecked, TokenType op, StaticType left, StaticType right);
+
+    void analyzeLoop(const Expression::expr_ptr &condition, const Statement::stmt_ptr &body,
+                     const Expression::expr_ptr &increment); // the increment is optional
+    void analyzeFunction(const FunctionStatement &stmt);
+    void declare(const Token &name, StaticType type);
+    void assign(const Token &name, StaticType type);
+    StaticType lookup(const Token &name) const;
+    std::size_t findLocal(const Token &name) const; // id of the variable, if it's declared in the current function
+    void markChecked(const Expression &expr, bool &unchecked, bool proven);
+
+    static constexpr std::size_t npos = SIZE_MAX;
+
+    const bool _trackGlobals;
+    std::vector<std::unordered_map<std::string, std::size_t>> _scopes; // name -> variable id
+    std::size_t _functionBase{0};                                      // first scope of the current function
+    std::size_t _nextId{0};
+    state_t _state;
+    bool _dead{false}; // the current point is unreachable (after a break or return)
+    std::vector<std::vector<state_t>> _breakStates; // states at the breaks of the enclosing loops
+    StaticType _type{StaticType::UNKNOWN};          // type of the last inferred expression
+
+    bool _collecting{false};                       // first run, only collects the names below
+    std::unordered_set<std::string> _escapedNames; // assigned from inside a function they aren't declared in
+    std::unordered_map<const Expression *, bool> _checks; // every checked operation -> is it proven
+};
+
+} // namespace lox
+
+#endif
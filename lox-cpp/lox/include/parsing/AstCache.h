@@ -0,0 +1,35 @@
+#ifndef ASTCACHE_H
+#define ASTCACHE_H
+
+#include "../AST/Statements.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace lox
+{
+
+// binary file with the analyzed AST of a script (after the static passes), later runs of the same source skip
+// scanning, parsing and the passes. the file is memory mapped and read in one pass, only the runtime caches of the
+// nodes start out empty. a file that doesn't match the source hash, the format version or the options is ignored
+class AstCache
+{
+  public:
+    static constexpr std::uint32_t version = 2; // bump on any change of the format or the nodes
+
+    static std::uint64_t hash(const std::string &sourceCode);
+
+    // next to the script (script.loxc) or in the cache directory, named by the hash
+    static std::string path(const std::string &script, const std::string &cacheDir, std::uint64_t hash);
+
+    static std::optional<Statement::stmt_vec> load(const std::string &path, std::uint64_t hash, bool lazy);
+    static bool store(const std::string &path, std::uint64_t hash, bool lazy, const Statement::stmt_vec &stmts);
+
+    // the same format in memory, a Program builds its copies of the AST from it
+    static std::optional<std::string> serialize(std::uint64_t hash, bool lazy, const Statement::stmt_vec &stmts);
+    static Statement::stmt_vec deserialize(const std::string &image, std::uint64_t hash, bool lazy); // throws
+};
+
+} // namespace lox
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "../AST/Expressions.h"
 #include "../AST/Statements.h"
+#include "../ErrorHandler.h"
 #include <vector>
 
 namespace lox
@@ -11,22 +12,44 @@ namespace lox
 class Parser
 {
   public:
-    Parser(std::vector<Token> &tokens) : _tokens{std::move(tokens)}
+    // lazy: the bodies of top level functions are only brace matched, they get parsed on the first call
+    Parser(std::vector<Token> &tokens, ErrorHandler &errors, bool lazy = false)
+        : _tokens{std::move(tokens)}, _errors{errors}, _lazy{lazy}
     {
         // EMPTY
     }
 
     Statement::stmt_vec parse();
 
+    bool hadError() const
+    {
+        return _hadError;
+    }
+
+    std::size_t lazyBodies() const
+    {
+        return _lazyBodies;
+    }
+    std::size_t lazyTokens() const
+    {
+        return _lazyTokens;
+    }
+
+    // smaller bodies are parsed right away, they are cheap and the Inliner wants to see them
+    static constexpr std::size_t minLazyTokens = 32;
+
   protected:
     // statement parsing
-    Statement::stmt_ptr declaration();
+    Statement::stmt_ptr declaration(bool topLevel = false);
+    Statement::stmt_ptr classDeclaration();
     Statement::stmt_ptr varDeclaration();
-    Statement::stmt_ptr function();
+    Statement::stmt_ptr function(bool lazy = false);
+    std::shared_ptr<LazyBody> skipBody(); // nullptr if the body is small or unbalanced, then it's parsed normally
     Statement::stmt_vec block(); // returns all the statements in the block
     Statement::stmt_ptr statement();
     Statement::stmt_ptr expressionStatement();
-    Statement::stmt_ptr forStatement();
+    Statement::stmt_ptr forStatement(bool parallel = false);
+    std::shared_ptr<Reduction> reduction(); // reduce(op) acc, behind the clauses of a parallel for
     Statement::stmt_ptr ifStatement();
     Statement::stmt_ptr printStatement();
     Statement::stmt_ptr returnStatement();
@@ -56,6 +79,9 @@ class Parser
     bool match(const std::vector<TokenType> &&);
     bool match(const TokenType &); // same but only for 1 TokenType
 
+    // reports a syntax error
+    void error(const Token &token, const std::string &message);
+
     // report error if next token isnt the expected one (and advance)
     Token consume(TokenType type, const std::string &&message);
 
@@ -83,6 +109,12 @@ class Parser
   private:
     const std::vector<Token> _tokens;
     int _current{0};
+    ErrorHandler &_errors;
+
+    const bool _lazy;
+    bool _hadError{false};
+    std::size_t _lazyBodies{0};
+    std::size_t _lazyTokens{0};
 };
 } // namespace lox
 
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 
+#include "../ErrorHandler.h"
 #include "Token.h"
 
 namespace lox
@@ -12,7 +13,7 @@ namespace lox
 class Scanner
 {
   public:
-    Scanner(const std::string &source) : _source(source){};
+    Scanner(const std::string &source, ErrorHandler &errors) : _source(source), _errors{errors} {};
 
     using tokenlist_t = std::vector<lox::Token>;
     tokenlist_t scanTokens();
@@ -39,6 +40,7 @@ class Scanner
   private:
     std::string _source;
     tokenlist_t _tokens;
+    ErrorHandler &_errors;
 
     int _start = 0;
     int _current = 0;
@@ -10,6 +10,12 @@
 namespace lox
 {
 
+// hash used for every identifier lookup (tokens and Environment::define)
+inline std::size_t hashName(const std::string &name)
+{
+    return std::hash<std::string>{}(name);
+}
+
 class Token
 {
   public:
@@ -17,6 +23,7 @@ class Token
     const std::string lexeme;
     const literal_t literal;
     const int line;
+    const std::size_t hash = hashName(lexeme); // computed once while scanning
 };
 
 } // namespace lox
@@ -15,96 +15,61 @@ class LoxCallable
   public:
     using callable_ptr = std::shared_ptr<LoxCallable>;
 
+    static constexpr int variadic = -1; // arity of callables that take any number of arguments
+
     virtual constexpr int arity() const = 0;
-    virtual literal_t call(Interpreter &, const std::vector<literal_t> &) const = 0;
+    // the paren of the call expression, for the line of errors thrown inside
+    virtual literal_t call(Interpreter &, const std::vector<literal_t> &args, const Token &paren) const = 0;
 
     virtual std::string toString() const
     {
         return "<callable>";
     }
-
-    void setLineToken(const Token &t)
-    {
-        _lineToken = std::make_unique<Token>(t);
-    }
-
-  protected:
-    std::unique_ptr<Token> _lineToken; // optional, can be used for throwing a LoxRuntimeError in call()
 };
 
 class LoxFunction final : public LoxCallable
 {
   public:
-    LoxFunction(const FunctionStatement &decl, const Environment::environment_ptr &closure)
-        : _declaration{decl}, _closure{closure}
-    {
-    }
+    using declaration_ptr = std::shared_ptr<const FunctionStatement>;
 
-    constexpr int arity() const override
+    LoxFunction(const declaration_ptr &decl, const Environment::environment_ptr &closure, bool isInitializer = false)
+        : _declaration{decl}, _closure{closure}, _isInitializer{isInitializer}
     {
-        return _declaration._params.size();
     }
 
-    literal_t call(Interpreter &, const std::vector<literal_t> &) const override;
-
-    std::string toString() const override
+    int arity() const override
     {
-        return "<fn " + _declaration._name.lexeme + ">";
+        return _declaration->_params.size();
     }
 
-  private:
-    const FunctionStatement _declaration;
-    const Environment::environment_ptr _closure;
-};
-
-// ------ native functions --------
-
-class ClockFunction final : public LoxCallable
-{
-  public:
-    constexpr int arity() const override
-    {
-        return 0;
-    }
+    literal_t call(Interpreter &, const std::vector<literal_t> &, const Token &) const override;
 
-    literal_t call(Interpreter &, const std::vector<literal_t> &) const override;
+    // calls the function as a method of the instance, without creating a bound method first
+    literal_t callMethod(Interpreter &, const std::vector<literal_t> &, const std::shared_ptr<LoxInstance> &,
+                         const Token &paren) const;
+    callable_ptr bind(const std::shared_ptr<LoxInstance> &instance) const;
 
     std::string toString() const override
     {
-        return "<native fn>";
+        return "<fn " + _declaration->_name.lexeme + ">";
     }
-};
 
-class InputFunction final : public LoxCallable
-{
-  public:
-    constexpr int arity() const override
+    const declaration_ptr &declaration() const
     {
-        return 0;
+        return _declaration;
     }
-
-    literal_t call(Interpreter &, const std::vector<literal_t> &) const override;
-
-    std::string toString() const override
+    const Environment::environment_ptr &closure() const
     {
-        return "<native fn>";
+        return _closure;
     }
-};
 
-class NumberFunction final : public LoxCallable
-{
-  public:
-    constexpr int arity() const override
-    {
-        return 1;
-    }
-
-    literal_t call(Interpreter &, const std::vector<literal_t> &) const override;
+  private:
+    literal_t invoke(Interpreter &, const std::vector<literal_t> &, const Environment::environment_ptr &env,
+                     const Token &paren) const;
 
-    std::string toString() const override
-    {
-        return "<native fn>";
-    }
+    const declaration_ptr _declaration;
+    const Environment::environment_ptr _closure;
+    const bool _isInitializer; // init() always returns this
 };
 
 } // namespace lox
@@ -0,0 +1,71 @@
+#ifndef HASHINDEX_H
+#define HASHINDEX_H
+
+#include <cstdint>
+#include <vector>
+
+namespace lox
+{
+
+// open-addressing (robin hood) index over an external, dense array of entries.
+// the index only stores the lower 32 bits of the hash and the slot of the entry,
+// so the entries themselves stay in insertion order and their slots never move.
+class HashIndex
+{
+  public:
+    static constexpr std::uint32_t npos = UINT32_MAX;
+
+    // returns the slot of the entry with the given hash for which isMatch(slot) is true (or npos)
+    template <typename Matcher> std::uint32_t find(std::size_t hash, Matcher &&isMatch) const
+    {
+        if (_buckets.empty())
+            return npos;
+
+        const std::uint32_t shortHash = static_cast<std::uint32_t>(hash);
+        std::size_t pos = shortHash & _mask;
+
+        for (std::size_t dist = 0;; pos = (pos + 1) & _mask, ++dist)
+        {
+            const Bucket &bucket = _buckets[pos];
+
+            // an empty bucket or a "richer" resident ends the probe sequence
+            if (bucket.slot == npos || distance(bucket, pos) < dist)
+                return npos;
+
+            if (bucket.hash == shortHash && isMatch(bucket.slot))
+                return bucket.slot;
+        }
+    }
+
+    // the key mustn't be in the index already
+    void insert(std::size_t hash, std::uint32_t slot);
+    void clear();
+
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+  private:
+    struct Bucket
+    {
+        std::uint32_t hash;
+        std::uint32_t slot;
+    };
+
+    std::size_t distance(const Bucket &bucket, std::size_t pos) const
+    {
+        return (pos - (bucket.hash & _mask)) & _mask;
+    }
+
+    void place(Bucket incoming);
+    void grow();
+
+    std::vector<Bucket> _buckets;
+    std::size_t _mask{0};
+    std::size_t _size{0};
+};
+
+} // namespace lox
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef LOXCLASS_H
+#define LOXCLASS_H
+
+#include "Callables.h"
+#include "Shape.h"
+#include <unordered_map>
+
+namespace lox
+{
+
+class LoxClass final : public LoxCallable, public std::enable_shared_from_this<LoxClass>
+{
+  public:
+    using class_ptr = std::shared_ptr<LoxClass>;
+    using method_map = std::unordered_map<std::string, std::shared_ptr<LoxFunction>>;
+
+    LoxClass(const std::string &name, const class_ptr &superclass, method_map &methods)
+        : _name{name}, _superclass{superclass}, _methods{std::move(methods)}, _rootShape{std::make_shared<Shape>()}
+    {
+    }
+
+    const LoxFunction *findMethod(const std::string &name) const; // nullptr if there's no such method
+
+    const Shape::shape_ptr &rootShape() const
+    {
+        return _rootShape;
+    }
+
+    // calling a class creates an instance, the arguments go to init()
+    int arity() const override
+    {
+        const LoxFunction *initializer = findMethod("init");
+        return initializer ? initializer->arity() : 0;
+    }
+
+    literal_t call(Interpreter &, const std::vector<literal_t> &, const Token &) const override;
+
+    std::string toString() const override
+    {
+        return _name;
+    }
+
+  private:
+    const std::string _name;
+    const class_ptr _superclass; // optional
+    const method_map _methods;
+    const Shape::shape_ptr _rootShape; // shape of new instances
+};
+
+// the fields of an instance are stored in a flat array, their names are in the (shared) shape
+class LoxInstance final : public std::enable_shared_from_this<LoxInstance>
+{
+  public:
+    using instance_ptr = std::shared_ptr<LoxInstance>;
+
+    LoxInstance(const LoxClass::class_ptr &klass) : _class{klass}, _shape{klass->rootShape()}
+    {
+    }
+
+    // finds a field or method through the inline cache of the access site, nullptr if there's no such property
+    const PropertyCache::Entry *lookup(const Token &name, PropertyCache &cache) const;
+
+    literal_t get(const Token &name, PropertyCache &cache); // fields or bound methods
+    void set(const Token &name, const literal_t &value, PropertyCache &cache);
+
+    const literal_t &field(std::uint32_t slot) const
+    {
+        return _fields[slot];
+    }
+
+    // same class, shape and fields, for copies of the Server's prelude
+    instance_ptr clone() const
+    {
+        return std::make_shared<LoxInstance>(*this);
+    }
+    std::size_t fieldCount() const
+    {
+        return _fields.size();
+    }
+    void setField(std::uint32_t slot, const literal_t &value)
+    {
+        _fields[slot] = value;
+    }
+
+    std::string toString() const
+    {
+        return _class->toString() + " instance";
+    }
+
+  private:
+    const LoxClass::class_ptr _class;
+    Shape::shape_ptr _shape;
+    std::vector<literal_t> _fields;
+};
+
+} // namespace lox
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef LOXFUTURE_H
+#define LOXFUTURE_H
+
+#include "Callables.h"
+#include "LoxLiterals.h"
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace lox
+{
+class EventLoop;
+
+// ---- async i/o: the operations run as coroutines on the i/o loop and hand out a future right away ----
+//
+// the script keeps going meanwhile and only waits in await(future), so any number of reads and timers overlap
+// with each other and with the computation. the loop is a single thread shared by all isolates.
+// it runs on epoll, on other platforms the operations fail with a NativeError
+
+#ifdef __linux__
+EventLoop &ioLoop();
+#endif
+
+// the result of an operation that may still be running
+class LoxFuture final : public LoxCallable
+{
+  public:
+    struct State
+    {
+        std::mutex mutex;
+        std::condition_variable finished;
+        bool done{false};
+        literal_t result;
+        std::string error; // the reason the operation failed, empty if it didn't
+    };
+
+    explicit LoxFuture(const std::shared_ptr<State> &state) : _state{state}
+    {
+    }
+
+    // futures aren't callable, taking any arguments gets them the right error
+    constexpr int arity() const override
+    {
+        return variadic;
+    }
+
+    literal_t call(Interpreter &, const std::vector<literal_t> &, const Token &) const override;
+
+    std::string toString() const override
+    {
+        return "<future>";
+    }
+
+    bool ready() const;
+    literal_t await() const; // throws a NativeError, if the operation failed
+
+    // ---- operations ----
+
+    static std::shared_ptr<LoxFuture> readFile(const std::string &path); // the whole file as a string
+    static std::shared_ptr<LoxFuture> readLine(); // the next line of stdin, nil at its end. don't mix with input()
+    static std::shared_ptr<LoxFuture> sleep(std::int64_t milliseconds); // nil, once the time is up
+
+  private:
+    const std::shared_ptr<State> _state;
+};
+
+} // namespace lox
+
+#endif
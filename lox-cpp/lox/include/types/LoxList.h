@@ -0,0 +1,59 @@
+#ifndef LOXLIST_H
+#define LOXLIST_H
+
+#include "LoxLiterals.h"
+#include <memory>
+#include <vector>
+
+namespace lox
+{
+
+// lox's list type.
+// as long as a list only holds numbers they are stored unboxed in one contiguous buffer of doubles,
+// the first non-number switches it over to boxed literal_t storage. ints are stored as doubles as well,
+// integral elements read back as ints
+class LoxList
+{
+  public:
+    using list_ptr = std::shared_ptr<LoxList>;
+
+    LoxList() = default;
+    LoxList(std::vector<literal_t> &&values);
+    LoxList(std::vector<double> &&numbers) : _numbers{std::move(numbers)}
+    {
+    }
+
+    std::size_t size() const
+    {
+        return _numeric ? _numbers.size() : _values.size();
+    }
+
+    bool isNumeric() const
+    {
+        return _numeric;
+    }
+
+    literal_t get(std::size_t index) const;
+    void set(std::size_t index, const literal_t &value);
+    void push(const literal_t &value);
+
+    // ---- kernels, they throw a NativeError if the list holds anything but numbers ----
+    double sum();
+    double min();
+    double max();
+    double dot(LoxList &other);
+    void scale(double factor);
+    void sort(); // numbers or strings
+
+  private:
+    void box(); // switch to boxed storage
+    std::vector<double> &numbers(); // the unboxed storage, switches back to it if possible
+
+    bool _numeric{true};
+    std::vector<double> _numbers; // storage while _numeric
+    std::vector<literal_t> _values; // storage otherwise
+};
+
+} // namespace lox
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef LOXLITERALS_H
 #define LOXLITERALS_H
 
+#include <cstdint>
 #include <string>
 #include <variant>
 #include <memory>
@@ -8,8 +9,12 @@
 namespace lox
 {
 class LoxCallable;
-// represents literals in Lox
-using literal_t = std::variant<std::nullptr_t, std::string, double, bool, std::shared_ptr<LoxCallable>>;
+class LoxInstance;
+class LoxList;
+class LoxMap;
+// represents literals in Lox, numbers are either doubles or (exact) integers, see Numbers.h
+using literal_t = std::variant<std::nullptr_t, std::string, double, std::int64_t, bool, std::shared_ptr<LoxCallable>,
+                               std::shared_ptr<LoxList>, std::shared_ptr<LoxMap>, std::shared_ptr<LoxInstance>>;
 
 } // namespace lox
 
@@ -0,0 +1,68 @@
+#ifndef LOXMAP_H
+#define LOXMAP_H
+
+#include "HashIndex.h"
+#include "LoxLiterals.h"
+#include <memory>
+#include <vector>
+
+namespace lox
+{
+
+// lox's map type, keys can be strings, numbers and bools.
+// the entries live in a dense vector in insertion order (so iterating is a linear scan), each with its cached
+// hash. a robin hood HashIndex over the entries does the lookups
+class LoxMap
+{
+  public:
+    using map_ptr = std::shared_ptr<LoxMap>;
+
+    static bool isValidKey(const literal_t &key);
+
+    // the key must be valid, returns nullptr if there is no such entry
+    const literal_t *get(const literal_t &key) const;
+    void set(const literal_t &key, const literal_t &value);
+    bool remove(const literal_t &key);
+
+    bool has(const literal_t &key) const
+    {
+        return get(key) != nullptr;
+    }
+
+    std::size_t size() const
+    {
+        return _entries.size() - _removed;
+    }
+
+    // calls f(key, value) for every entry in insertion order
+    template <typename F> void forEach(F &&f) const
+    {
+        for (const Entry &entry : _entries)
+        {
+            if (entry.alive)
+                f(entry.key, entry.value);
+        }
+    }
+
+  private:
+    struct Entry
+    {
+        std::size_t hash;
+        literal_t key;
+        literal_t value;
+        bool alive;
+    };
+
+    static literal_t normalizeKey(const literal_t &key); // integral doubles become ints, so 1 and 1.0 are one key
+    static std::size_t hashKey(const literal_t &key);
+    std::uint32_t find(std::size_t hash, const literal_t &key) const;
+    void compact(); // drops removed entries and rebuilds the index
+
+    std::vector<Entry> _entries;
+    HashIndex _index;
+    std::size_t _removed{0}; // removed entries stay in place until the next compaction
+};
+
+} // namespace lox
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef LOXTASK_H
+#define LOXTASK_H
+
+#include "../evaluating/Environment.h"
+#include "../scanning/Token.h"
+#include "Callables.h"
+#include "LoxLiterals.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace lox
+{
+class ForStatement;
+class ThreadPool;
+
+// ---- tasks: spawn(fn, args...) runs a top level function in an isolate of its own on the task pool ----
+//
+// the isolate gets its own copy of the running program (see Program) with the functions and classes declared,
+// plus copies of the globals that can cross. values cross isolates as deep copies: nil, bools, numbers, strings,
+// lists and maps of those, and channels, which are shared. functions, classes and instances stay where they are
+
+ThreadPool &taskPool(); // shared by all isolates, one thread per core
+
+// a deep copy that can go to another isolate, nothing if the value (or something in it) can't cross
+std::optional<literal_t> transfer(const literal_t &value);
+
+// runs the iterations of a parallel for loop (see Reduction) as tasks. the range is split into chunks by the
+// number of iterations alone, so the results don't depend on the number of threads. every chunk runs the body on
+// copies of the variables it sees in scope, with the accumulator starting at identity. a chunk whose copies were
+// changed (by a function called in the body) fails, the change would be lost.
+// returns the partial results in chunk order, throws the runtime error of the first chunk that failed
+std::vector<literal_t> runChunks(Interpreter &interpreter, const ForStatement &loop,
+                                 const Environment::environment_ptr &scope, std::int64_t first,
+                                 std::uint64_t iterations, const literal_t &identity);
+
+// the spawn native, it takes the function and any number of arguments for it
+class SpawnFunction final : public LoxCallable
+{
+  public:
+    constexpr int arity() const override
+    {
+        return variadic;
+    }
+
+    literal_t call(Interpreter &, const std::vector<literal_t> &, const Token &) const override;
+
+    std::string toString() const override
+    {
+        return "<native fn spawn>";
+    }
+};
+
+// the handle of a spawned task, join() waits for its result. the output of the task is printed when it's joined
+class LoxTask final : public LoxCallable
+{
+  public:
+    struct State
+    {
+        std::mutex mutex;
+        std::condition_variable finished;
+        bool done{false};
+        literal_t result;
+        std::string error; // the runtime error that ended the task, empty if there was none
+        std::string out;
+        std::string err;
+    };
+
+    explicit LoxTask(const std::shared_ptr<State> &state) : _state{state}
+    {
+    }
+
+    // handles aren't callable, taking any arguments gets them the right error
+    constexpr int arity() const override
+    {
+        return variadic;
+    }
+
+    literal_t call(Interpreter &, const std::vector<literal_t> &, const Token &) const override;
+
+    std::string toString() const override
+    {
+        return "<task>";
+    }
+
+    literal_t join(Interpreter &interpreter) const; // throws a NativeError, if the task failed
+
+  private:
+    const std::shared_ptr<State> _state;
+};
+
+// bounded queue between isolates, send blocks while it's full and receive while it's empty
+class LoxChannel final : public LoxCallable
+{
+  public:
+    explicit LoxChannel(std::size_t capacity) : _capacity{capacity}
+    {
+    }
+
+    constexpr int arity() const override
+    {
+        return variadic;
+    }
+
+    literal_t call(Interpreter &, const std::vector<literal_t> &, const Token &) const override;
+
+    std::string toString() const override
+    {
+        return "<channel>";
+    }
+
+    void send(const literal_t &value); // throws a NativeError, if the channel is closed
+    literal_t receive();               // nil, once the channel is closed and empty
+    void close();
+
+  private:
+    const std::size_t _capacity;
+
+    std::mutex _mutex;
+    std::condition_variable _changed;
+    std::deque<literal_t> _values;
+    bool _closed{false};
+};
+
+} // namespace lox
+
+#endif
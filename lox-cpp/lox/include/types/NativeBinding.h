@@ -0,0 +1,141 @@
+#ifndef NATIVEBINDING_H
+#define NATIVEBINDING_H
+
+#include "../evaluating/Environment.h"
+#include "Callables.h"
+#include "LoxLiterals.h"
+#include "Numbers.h"
+#include "Throwables.h"
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lox
+{
+
+// ------ conversions between lox and c++ values ------
+
+template <typename T> constexpr const char *nativeTypeName()
+{
+    if constexpr (std::is_same_v<T, double>)
+        return "a number";
+    else if constexpr (std::is_same_v<T, bool>)
+        return "a bool";
+    else if constexpr (std::is_same_v<T, std::string>)
+        return "a string";
+    else if constexpr (std::is_same_v<T, std::shared_ptr<LoxList>>)
+        return "a list";
+    else if constexpr (std::is_same_v<T, std::shared_ptr<LoxMap>>)
+        return "a map";
+    else if constexpr (std::is_same_v<T, std::shared_ptr<LoxInstance>>)
+        return "an instance";
+    else
+        return "a callable";
+}
+
+// type-checked access to an argument, T = literal_t accepts anything and T = double accepts ints as well
+template <typename T> decltype(auto) unboxArgument(const literal_t &value, std::size_t index, const Token &callSite)
+{
+    if constexpr (std::is_same_v<T, literal_t>)
+        return value;
+    else if constexpr (std::is_same_v<T, double>)
+    {
+        if (!isNumber(value))
+            throw LoxRuntimeError{"Argument " + std::to_string(index + 1) + " must be a number.", callSite};
+
+        return toDouble(value);
+    }
+    else
+    {
+        if (!std::holds_alternative<T>(value))
+        {
+            const std::string msg = "Argument " + std::to_string(index + 1) + " must be " + nativeTypeName<T>() + ".";
+            throw LoxRuntimeError{msg, callSite};
+        }
+
+        return std::get<T>(value);
+    }
+}
+
+// ------ native function adapter ------
+
+// natives that need the interpreter (e.g. to define globals) take it as their first parameter
+template <typename... Args> constexpr bool takesInterpreter = false;
+template <typename... Rest> constexpr bool takesInterpreter<Interpreter &, Rest...> = true;
+
+// wraps a plain c++ function, arity and argument checks are derived from its signature.
+// the function can throw a NativeError, it gets reported at the call site
+template <typename R, typename... Args> class NativeFunction final : public LoxCallable
+{
+  public:
+    using function_t = R (*)(Args...);
+
+    NativeFunction(function_t function) : _function{function}
+    {
+    }
+
+    constexpr int arity() const override
+    {
+        return loxArity;
+    }
+
+    literal_t call(Interpreter &interpreter, const std::vector<literal_t> &args, const Token &paren) const override
+    {
+        try
+        {
+            return invoke(interpreter, args, paren, std::make_index_sequence<loxArity>{});
+        }
+        catch (const NativeError &e)
+        {
+            throw LoxRuntimeError{e.what(), paren};
+        }
+    }
+
+    std::string toString() const override
+    {
+        return "<native fn>";
+    }
+
+  private:
+    static constexpr std::size_t offset = takesInterpreter<Args...> ? 1 : 0;
+    static constexpr int loxArity = sizeof...(Args) - offset;
+
+    // type of the I-th lox argument
+    template <std::size_t I>
+    using arg_t = std::remove_cvref_t<std::tuple_element_t<I + offset, std::tuple<Args...>>>;
+
+    template <std::size_t... I>
+    literal_t invoke(Interpreter &interpreter, const std::vector<literal_t> &args, const Token &paren,
+                     std::index_sequence<I...>) const
+    {
+        const auto callFunction = [&]() -> R {
+            if constexpr (takesInterpreter<Args...>)
+                return _function(interpreter, unboxArgument<arg_t<I>>(args[I], I, paren)...);
+            else
+                return _function(unboxArgument<arg_t<I>>(args[I], I, paren)...);
+        };
+
+        if constexpr (std::is_void_v<R>)
+        {
+            callFunction();
+            return nullptr;
+        }
+        else
+            return literal_t{callFunction()};
+    }
+
+    const function_t _function;
+};
+
+// defines a native function in the given environment, e.g. bindNative(globals, "sqrt", &nativeSqrt)
+template <typename R, typename... Args>
+void bindNative(Environment &environment, const std::string &name, R (*function)(Args...))
+{
+    environment.define(name, std::make_shared<NativeFunction<R, Args...>>(function));
+}
+
+} // namespace lox
+
+#endif
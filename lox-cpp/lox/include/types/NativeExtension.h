@@ -0,0 +1,51 @@
+#ifndef NATIVEEXTENSION_H
+#define NATIVEEXTENSION_H
+
+#include "../LoxNative.h"
+#include "Callables.h"
+#include <memory>
+#include <string>
+
+namespace lox
+{
+class Environment;
+
+// a function defined by a native extension module through the C interface in LoxNative.h
+class ExtensionFunction final : public LoxCallable
+{
+  public:
+    using library_ptr = std::shared_ptr<void>; // closes the module once no function uses it anymore
+
+    ExtensionFunction(const std::string &name, int arity, lox_native_fn function, void *userdata,
+                      library_ptr library)
+        : _name{name}, _arity{arity}, _function{function}, _userdata{userdata}, _library{std::move(library)}
+    {
+    }
+
+    constexpr int arity() const override
+    {
+        return _arity;
+    }
+
+    literal_t call(Interpreter &, const std::vector<literal_t> &, const Token &) const override;
+
+    std::string toString() const override
+    {
+        return "<native fn " + _name + ">";
+    }
+
+  private:
+    const std::string _name;
+    const int _arity;
+    const lox_native_fn _function;
+    void *const _userdata;
+    const library_ptr _library;
+};
+
+// opens the shared library and lets it define its functions into the environment,
+// throws a NativeError if the library or its entry point can't be loaded, or if it would redefine a variable
+void loadNativeExtension(Environment &environment, const std::string &path);
+
+} // namespace lox
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef NATIVES_H
+#define NATIVES_H
+
+#include "LoxLiterals.h"
+#include <string>
+
+namespace lox
+{
+class Environment;
+class Interpreter;
+class LoxList;
+class LoxMap;
+using callable_ptr = std::shared_ptr<LoxCallable>;
+using list_ptr = std::shared_ptr<LoxList>;
+using map_ptr = std::shared_ptr<LoxMap>;
+
+// the c++ implementations of the native functions, exposed to lox with bindNative()
+namespace natives
+{
+double clock();
+std::string input();
+double number(const literal_t &value);
+void loadNative(Interpreter &interpreter, const std::string &path);
+
+// lists
+std::int64_t len(const literal_t &value); // strings, lists and maps
+list_ptr list(double size, const literal_t &fill);
+void push(const list_ptr &list, const literal_t &value);
+double sum(const list_ptr &list);
+double min(const list_ptr &list);
+double max(const list_ptr &list);
+double dot(const list_ptr &a, const list_ptr &b);
+void scale(const list_ptr &list, double factor);
+void sort(const list_ptr &list);
+
+// maps
+map_ptr map();
+literal_t get(const map_ptr &map, const literal_t &key); // nil if missing
+void set(const map_ptr &map, const literal_t &key, const literal_t &value);
+bool has(const map_ptr &map, const literal_t &key);
+bool remove(const map_ptr &map, const literal_t &key); // false if the key wasn't there
+list_ptr keys(const map_ptr &map);                     // in insertion order
+list_ptr values(const map_ptr &map);
+
+// tasks and channels (see LoxTask.h), spawn takes any number of arguments and is a callable of its own
+literal_t join(Interpreter &interpreter, const callable_ptr &task);
+callable_ptr channel(double capacity);
+void send(const callable_ptr &channel, const literal_t &value);
+literal_t receive(const callable_ptr &channel); // nil, once the channel is closed and empty
+void close(const callable_ptr &channel);
+
+// async i/o (see LoxFuture.h), the operations return a future right away, await waits for its result
+callable_ptr readFile(const std::string &path);
+callable_ptr readLine();
+callable_ptr sleep(double milliseconds);
+literal_t await(const callable_ptr &future); // throws, if the operation failed
+bool ready(const callable_ptr &future);
+} // namespace natives
+
+// binds all the functions above into the given (global) environment
+void defineNatives(Environment &globals);
+
+} // namespace lox
+
+#endif
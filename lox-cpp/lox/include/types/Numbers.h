@@ -0,0 +1,179 @@
+#ifndef NUMBERS_H
+#define NUMBERS_H
+
+#include "LoxLiterals.h"
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace lox
+{
+// lox only has one number type, but integral values are kept as int64 internally (see literal_t).
+// results stay integers as long as they are exact, otherwise (overflow, fractions) they become doubles
+
+inline bool isNumber(const literal_t &value)
+{
+    return std::holds_alternative<std::int64_t>(value) || std::holds_alternative<double>(value);
+}
+
+// the value must be a number
+inline double toDouble(const literal_t &value)
+{
+    if (std::holds_alternative<std::int64_t>(value))
+        return static_cast<double>(std::get<std::int64_t>(value));
+
+    return std::get<double>(value);
+}
+
+namespace numbers
+{
+using int_t = std::int64_t;
+
+inline bool bothInts(const literal_t &a, const literal_t &b)
+{
+    return std::holds_alternative<int_t>(a) && std::holds_alternative<int_t>(b);
+}
+
+// ---- overflow checked integer operations, return false on overflow ----
+
+inline bool addInts(int_t a, int_t b, int_t &result)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return !__builtin_add_overflow(a, b, &result);
+#else
+    if ((b > 0 && a > std::numeric_limits<int_t>::max() - b) || (b < 0 && a < std::numeric_limits<int_t>::min() - b))
+        return false;
+    result = a + b;
+    return true;
+#endif
+}
+
+inline bool subtractInts(int_t a, int_t b, int_t &result)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return !__builtin_sub_overflow(a, b, &result);
+#else
+    if ((b < 0 && a > std::numeric_limits<int_t>::max() + b) || (b > 0 && a < std::numeric_limits<int_t>::min() + b))
+        return false;
+    result = a - b;
+    return true;
+#endif
+}
+
+inline bool multiplyInts(int_t a, int_t b, int_t &result)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return !__builtin_mul_overflow(a, b, &result);
+#else
+    const int_t max = std::numeric_limits<int_t>::max();
+    const int_t min = std::numeric_limits<int_t>::min();
+
+    if (a > 0 ? (b > 0 ? a > max / b : b < min / a) : (b > 0 ? a < min / b : a != 0 && b < max / a))
+        return false;
+    result = a * b;
+    return true;
+#endif
+}
+
+// ---- arithmetic on two numbers ----
+
+inline literal_t add(const literal_t &a, const literal_t &b)
+{
+    int_t result;
+    if (bothInts(a, b) && addInts(std::get<int_t>(a), std::get<int_t>(b), result))
+        return result;
+
+    return toDouble(a) + toDouble(b);
+}
+
+inline literal_t subtract(const literal_t &a, const literal_t &b)
+{
+    int_t result;
+    if (bothInts(a, b) && subtractInts(std::get<int_t>(a), std::get<int_t>(b), result))
+        return result;
+
+    return toDouble(a) - toDouble(b);
+}
+
+inline literal_t multiply(const literal_t &a, const literal_t &b)
+{
+    int_t result;
+    if (bothInts(a, b) && multiplyInts(std::get<int_t>(a), std::get<int_t>(b), result))
+    {
+        // -0 only exists as a double (0 * -1)
+        if (result != 0 || (std::get<int_t>(a) < 0) == (std::get<int_t>(b) < 0))
+            return result;
+    }
+
+    return toDouble(a) * toDouble(b);
+}
+
+// the divisor mustn't be 0
+inline literal_t divide(const literal_t &a, const literal_t &b)
+{
+    if (bothInts(a, b))
+    {
+        const int_t x = std::get<int_t>(a);
+        const int_t y = std::get<int_t>(b);
+
+        // min / -1 overflows (x % y too, it traps), -0 only exists as a double (0 / -3)
+        if (!(x == std::numeric_limits<int_t>::min() && y == -1) && !(x == 0 && y < 0) && x % y == 0)
+            return x / y;
+    }
+
+    return toDouble(a) / toDouble(b);
+}
+
+inline literal_t negate(const literal_t &a)
+{
+    if (std::holds_alternative<int_t>(a))
+    {
+        const int_t x = std::get<int_t>(a);
+        if (x != 0 && x != std::numeric_limits<int_t>::min()) // -0 only exists as a double
+            return -x;
+    }
+
+    return -toDouble(a);
+}
+
+// ---- comparison ----
+
+inline bool less(const literal_t &a, const literal_t &b)
+{
+    if (bothInts(a, b))
+        return std::get<int_t>(a) < std::get<int_t>(b);
+
+    return toDouble(a) < toDouble(b);
+}
+
+inline bool lessEqual(const literal_t &a, const literal_t &b)
+{
+    if (bothInts(a, b))
+        return std::get<int_t>(a) <= std::get<int_t>(b);
+
+    return toDouble(a) <= toDouble(b);
+}
+
+inline bool equal(const literal_t &a, const literal_t &b)
+{
+    if (bothInts(a, b))
+        return std::get<int_t>(a) == std::get<int_t>(b);
+
+    return toDouble(a) == toDouble(b);
+}
+
+// integral doubles (in the range where doubles are exact) as ints, e.g. to normalize map keys
+inline literal_t normalize(double value)
+{
+    constexpr double exactLimit = 9007199254740992.0; // 2^53
+
+    if (std::abs(value) <= exactLimit && std::floor(value) == value && !(value == 0 && std::signbit(value)))
+        return static_cast<int_t>(value);
+
+    return value;
+}
+
+} // namespace numbers
+} // namespace lox
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef SHAPE_H
+#define SHAPE_H
+
+#include "HashIndex.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lox
+{
+class Token;
+
+// hidden class of an instance: maps its field names to slots in the instance's flat field array.
+// instances that got the same fields in the same order share one shape, so property access sites can cache
+// "shape id -> slot" (see PropertyCache) instead of looking the name up every time.
+// every class has its own root shape, so a shape also implies the class (and its methods)
+class Shape
+{
+  public:
+    using shape_ptr = std::shared_ptr<Shape>;
+
+    Shape();
+
+    std::uint32_t id() const
+    {
+        return _id;
+    }
+
+    std::size_t fieldCount() const
+    {
+        return _fields.size();
+    }
+
+    std::uint32_t slotOf(const Token &name) const; // HashIndex::npos if there's no such field
+    shape_ptr withField(const Token &name);        // shape after adding the field, created once and reused
+
+  private:
+    struct Field
+    {
+        std::size_t hash;
+        std::string name;
+    };
+
+    struct Transition
+    {
+        std::size_t hash;
+        std::string name;
+        shape_ptr shape;
+    };
+
+    static constexpr std::size_t linearScanLimit = 8;
+
+    const std::uint32_t _id;
+    std::vector<Field> _fields; // index = slot
+    HashIndex _index;           // only for shapes with many fields
+    std::vector<Transition> _transitions;
+};
+
+} // namespace lox
+
+#endif
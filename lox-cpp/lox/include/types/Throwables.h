@@ -26,6 +26,13 @@ class LoxRuntimeError : public std::runtime_error
     const Token token;
 };
 
+// thrown by native functions (see NativeBinding.h), reported as a LoxRuntimeError at the call site
+class NativeError : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
 // for throwing in a while loop (break statement) -> gets catched so the while
 // loop breaks
 class Break : public std::exception
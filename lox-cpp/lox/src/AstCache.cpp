@@ -0,0 +1,973 @@
+#include "../include/parsing/AstCache.h"
+#include "../include/AST/Visitor.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace lox;
+
+namespace
+{
+constexpr char magic[4] = {'L', 'O', 'X', 'C'};
+
+struct Header
+{
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t hash;
+    std::uint32_t lazy;
+    std::uint32_t strings; // number of entries in the string table, which follows the header
+};
+
+// unique for every store, concurrent writers of the same cache file (other processes or threads) don't share it
+std::string temporaryPath(const std::string &path)
+{
+    static std::atomic<std::uint32_t> counter = 0;
+#ifdef _WIN32
+    const int process = _getpid();
+#else
+    const int process = ::getpid();
+#endif
+    return path + "." + std::to_string(process) + "." + std::to_string(counter.fetch_add(1)) + ".tmp";
+}
+
+enum class Node : std::uint8_t
+{
+    NONE, // nullptr
+    // expressions
+    ASSIGN,
+    BINARY,
+    CALL,
+    GET,
+    GROUPING,
+    INDEX,
+    INDEX_ASSIGN,
+    LIST,
+    LITERAL,
+    LOGICAL,
+    SET,
+    SUPER,
+    THIS,
+    UNARY,
+    VARIABLE,
+    INCREMENT,
+    COMPARE_CONST,
+    ASSIGN_BINARY,
+    LITERAL_CALL,
+    // statements
+    IF,
+    BLOCK,
+    CLASS,
+    EXPRESSION,
+    FUNCTION,
+    VAR,
+    PRINT,
+    RETURN,
+    WHILE,
+    FOR,
+    BREAK
+};
+
+// only the literals the parser creates can appear in the AST
+enum class Literal : std::uint8_t
+{
+    NIL,
+    STRING,
+    NUMBER,
+    INT,
+    BOOL
+};
+
+// ----------- writing ------------
+
+// writes the nodes in prefix order, strings go to a table so every name is stored once
+class Writer : public ExprVisitor, public StmtVisitor
+{
+  public:
+    void statements(const Statement::stmt_vec &stmts)
+    {
+        put<std::uint32_t>(stmts.size());
+        for (const Statement::stmt_ptr &stmt : stmts)
+            statement(stmt);
+    }
+
+    const std::string &nodes() const
+    {
+        return _out;
+    }
+    const std::vector<std::string> &strings() const
+    {
+        return _strings;
+    }
+
+    // statements
+    void visitIfStmt(const IfStatement &stmt) override
+    {
+        tag(Node::IF);
+        expression(stmt._condition);
+        statement(stmt._thenBranch);
+        statement(stmt._elseBranch);
+    }
+
+    void visitBlockStmt(const BlockStatement &stmt) override
+    {
+        tag(Node::BLOCK);
+        statements(stmt._statements);
+    }
+
+    void visitClassStmt(const ClassStatement &stmt) override
+    {
+        tag(Node::CLASS);
+        token(stmt._name);
+        expression(stmt._superclass);
+
+        put<std::uint32_t>(stmt._methods.size());
+        for (const ClassStatement::function_ptr &method : stmt._methods)
+            visitFunctionStatement(*method);
+    }
+
+    void visitExpressionStmt(const ExpressionStatement &stmt) override
+    {
+        tag(Node::EXPRESSION);
+        expression(stmt._expr);
+    }
+
+    void visitFunctionStatement(const FunctionStatement &stmt) override
+    {
+        tag(Node::FUNCTION);
+        token(stmt._name);
+        tokens(stmt._params);
+
+        // a lazy body that was parsed already (the program is running, see Program) is written like any other
+        const bool parsed = stmt._lazy && stmt._lazy->state == LazyBody::State::PARSED;
+        if (stmt._lazy && stmt._lazy->state == LazyBody::State::FAILED)
+            throw std::runtime_error{"function body with errors"}; // its tokens are gone
+
+        put<std::uint8_t>(stmt._lazy && !parsed);
+        if (!stmt._lazy || parsed)
+        {
+            statements(parsed ? stmt._lazy->body : stmt._body);
+            return;
+        }
+
+        tokens(stmt._lazy->tokens);
+        put<std::uint32_t>(stmt._lazy->assigned.size());
+        for (const std::string &name : stmt._lazy->assigned)
+            string(name);
+    }
+
+    void visitVarStmt(const VarStatement &stmt) override
+    {
+        tag(Node::VAR);
+        token(stmt._name);
+        expression(stmt._initializer);
+    }
+
+    void visitPrintStmt(const PrintStatement &stmt) override
+    {
+        tag(Node::PRINT);
+        expression(stmt._expr);
+    }
+
+    void visitReturnStmt(const ReturnStatement &stmt) override
+    {
+        tag(Node::RETURN);
+        token(stmt._keyword);
+        expression(stmt._value);
+    }
+
+    void visitWhileStmt(const WhileStatement &stmt) override
+    {
+        tag(Node::WHILE);
+        expression(stmt._condition);
+        statement(stmt._body);
+    }
+
+    void visitForStmt(const ForStatement &stmt) override
+    {
+        tag(Node::FOR);
+        visitVarStmt(*stmt._initializer);
+        expression(stmt._condition);
+        expression(stmt._increment);
+        statement(stmt._body);
+        expression(stmt._bound);
+        token(stmt._comparison);
+        put<std::int64_t>(stmt._step);
+
+        put<std::uint8_t>(stmt._reduction != nullptr);
+        if (stmt._reduction)
+        {
+            token(stmt._reduction->op);
+            token(stmt._reduction->accumulator);
+            put<std::uint8_t>(stmt._reduction->isGlobal);
+        }
+    }
+
+    void visitBreakStmt(const BreakStatement &stmt) override
+    {
+        tag(Node::BREAK);
+        token(stmt._keyword);
+    }
+
+    // expressions
+    void visitAssignExpr(const AssignExpression &expr) override
+    {
+        tag(Node::ASSIGN);
+        token(expr._name);
+        expression(expr._value);
+        put<std::uint8_t>(expr._isGlobal);
+    }
+
+    void visitBinaryExpr(const BinaryExpression &expr) override
+    {
+        tag(Node::BINARY);
+        expression(expr._left);
+        token(expr._operator);
+        expression(expr._right);
+        put<std::uint8_t>(expr._unchecked);
+    }
+
+    void visitCallExpr(const CallExpression &expr) override
+    {
+        tag(Node::CALL);
+        expression(expr._callee);
+        token(expr._paren);
+        expressions(expr._args);
+    }
+
+    void visitGetExpr(const GetExpression &expr) override
+    {
+        tag(Node::GET);
+        expression(expr._object);
+        token(expr._name);
+    }
+
+    void visitGroupingExpr(const GroupingExpression &expr) override
+    {
+        tag(Node::GROUPING);
+        expression(expr._expression);
+    }
+
+    void visitIndexExpr(const IndexExpression &expr) override
+    {
+        tag(Node::INDEX);
+        expression(expr._object);
+        token(expr._bracket);
+        expression(expr._index);
+    }
+
+    void visitIndexAssignExpr(const IndexAssignExpression &expr) override
+    {
+        tag(Node::INDEX_ASSIGN);
+        expression(expr._object);
+        token(expr._bracket);
+        expression(expr._index);
+        expression(expr._value);
+    }
+
+    void visitListExpr(const ListExpression &expr) override
+    {
+        tag(Node::LIST);
+        expressions(expr._elements);
+    }
+
+    void visitLiteralExpr(const LiteralExpression &expr) override
+    {
+        tag(Node::LITERAL);
+        literal(expr._value);
+    }
+
+    void visitLogicalExpr(const LogicalExpression &expr) override
+    {
+        tag(Node::LOGICAL);
+        expression(expr._left);
+        token(expr._operator);
+        expression(expr._right);
+    }
+
+    void visitSetExpr(const SetExpression &expr) override
+    {
+        tag(Node::SET);
+        expression(expr._object);
+        token(expr._name);
+        expression(expr._value);
+    }
+
+    void visitSuperExpr(const SuperExpression &expr) override
+    {
+        tag(Node::SUPER);
+        token(expr._keyword);
+        token(expr._method);
+    }
+
+    void visitThisExpr(const ThisExpression &expr) override
+    {
+        tag(Node::THIS);
+        token(expr._keyword);
+    }
+
+    void visitUnaryExpr(const UnaryExpression &expr) override
+    {
+        tag(Node::UNARY);
+        token(expr._operator);
+        expression(expr._right);
+        put<std::uint8_t>(expr._unchecked);
+    }
+
+    void visitVarExpr(const VarExpression &expr) override
+    {
+        tag(Node::VARIABLE);
+        token(expr._name);
+        put<std::uint8_t>(expr._isGlobal);
+    }
+
+    // fused expressions
+    void visitIncrementExpr(const IncrementExpression &expr) override
+    {
+        tag(Node::INCREMENT);
+        token(expr._name);
+        token(expr._operator);
+        literal(expr._delta);
+        put<std::uint8_t>(expr._isGlobal);
+        put<std::uint8_t>(expr._unchecked);
+    }
+
+    void visitCompareConstExpr(const CompareConstExpression &expr) override
+    {
+        tag(Node::COMPARE_CONST);
+        token(expr._name);
+        token(expr._operator);
+        literal(expr._constant);
+        put<std::uint8_t>(expr._isGlobal);
+        put<std::uint8_t>(expr._unchecked);
+    }
+
+    void visitAssignBinaryExpr(const AssignBinaryExpression &expr) override
+    {
+        tag(Node::ASSIGN_BINARY);
+        token(expr._name);
+        token(expr._operator);
+        expression(expr._right);
+        put<std::uint8_t>(expr._isGlobal);
+        put<std::uint8_t>(expr._unchecked);
+    }
+
+    void visitLiteralCallExpr(const LiteralCallExpression &expr) override
+    {
+        tag(Node::LITERAL_CALL);
+        visitCallExpr(*expr._call);
+
+        put<std::uint32_t>(expr._args.size());
+        for (const literal_t &arg : expr._args)
+            literal(arg);
+    }
+
+  private:
+    template <typename T> void put(T value)
+    {
+        _out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void tag(Node node)
+    {
+        put(node);
+    }
+
+    void string(const std::string &str)
+    {
+        const auto [it, inserted] = _indices.try_emplace(str, _strings.size());
+        if (inserted)
+            _strings.push_back(str);
+
+        put<std::uint32_t>(it->second);
+    }
+
+    void literal(const literal_t &value)
+    {
+        if (std::holds_alternative<std::nullptr_t>(value))
+            put(Literal::NIL);
+        else if (const std::string *str = std::get_if<std::string>(&value))
+        {
+            put(Literal::STRING);
+            string(*str);
+        }
+        else if (const double *number = std::get_if<double>(&value))
+        {
+            put(Literal::NUMBER);
+            put(*number);
+        }
+        else if (const std::int64_t *integer = std::get_if<std::int64_t>(&value))
+        {
+            put(Literal::INT);
+            put(*integer);
+        }
+        else if (const bool *boolean = std::get_if<bool>(&value))
+        {
+            put(Literal::BOOL);
+            put<std::uint8_t>(*boolean);
+        }
+        else
+            throw std::runtime_error{"runtime value in the AST"};
+    }
+
+    void token(const Token &token)
+    {
+        put<std::uint8_t>(static_cast<std::uint8_t>(token.type));
+        string(token.lexeme);
+        literal(token.literal);
+        put<std::int32_t>(token.line);
+    }
+
+    void tokens(const std::vector<Token> &tokens)
+    {
+        put<std::uint32_t>(tokens.size());
+        for (const Token &t : tokens)
+            token(t);
+    }
+
+    void statement(const Statement::stmt_ptr &stmt)
+    {
+        if (stmt)
+            stmt->accept(*this);
+        else
+            tag(Node::NONE);
+    }
+
+    void expression(const Expression::expr_ptr &expr)
+    {
+        if (expr)
+            expr->accept(*this);
+        else
+            tag(Node::NONE);
+    }
+
+    void expressions(const Expression::expr_vec &exprs)
+    {
+        put<std::uint32_t>(exprs.size());
+        for (const Expression::expr_ptr &expr : exprs)
+            expression(expr);
+    }
+
+    std::string _out;
+    std::vector<std::string> _strings;
+    std::unordered_map<std::string, std::uint32_t> _indices;
+};
+
+// ----------- reading ------------
+
+// builds the nodes from the mapped file, throws on anything that doesn't fit (truncated or corrupt file)
+class Reader
+{
+  public:
+    Reader(const char *begin, const char *end) : _pos{begin}, _end{end}
+    {
+    }
+
+    bool atEnd() const
+    {
+        return _pos == _end;
+    }
+
+    void readStrings(std::uint32_t count)
+    {
+        _strings.reserve(count);
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            const std::uint32_t length = get<std::uint32_t>();
+            need(length);
+            _strings.emplace_back(_pos, length);
+            _pos += length;
+        }
+    }
+
+    Statement::stmt_vec statements()
+    {
+        Statement::stmt_vec stmts(get<std::uint32_t>());
+        for (Statement::stmt_ptr &stmt : stmts)
+            stmt = statement();
+
+        return stmts;
+    }
+
+    Statement::stmt_ptr statement()
+    {
+        switch (get<Node>())
+        {
+        case Node::NONE:
+            return nullptr;
+
+        case Node::IF: {
+            Expression::expr_ptr condition = expression();
+            Statement::stmt_ptr thenBranch = statement();
+            Statement::stmt_ptr elseBranch = statement();
+            return std::make_shared<IfStatement>(condition, thenBranch, elseBranch);
+        }
+        case Node::BLOCK: {
+            Statement::stmt_vec stmts = statements();
+            return std::make_shared<BlockStatement>(stmts);
+        }
+        case Node::CLASS: {
+            const Token name = token();
+            std::shared_ptr<VarExpression> superclass = as<VarExpression>(expression(), true);
+
+            std::vector<ClassStatement::function_ptr> methods(get<std::uint32_t>());
+            for (ClassStatement::function_ptr &method : methods)
+                method = as<FunctionStatement>(statement(), false);
+
+            return std::make_shared<ClassStatement>(name, superclass, methods);
+        }
+        case Node::EXPRESSION: {
+            Expression::expr_ptr expr = expression();
+            return std::make_shared<ExpressionStatement>(expr);
+        }
+        case Node::FUNCTION:
+            return function();
+        case Node::VAR: {
+            const Token name = token();
+            Expression::expr_ptr initializer = expression();
+            return std::make_shared<VarStatement>(name, initializer);
+        }
+        case Node::PRINT: {
+            Expression::expr_ptr expr = expression();
+            return std::make_shared<PrintStatement>(expr);
+        }
+        case Node::RETURN: {
+            const Token keyword = token();
+            Expression::expr_ptr value = expression();
+            return std::make_shared<ReturnStatement>(keyword, value);
+        }
+        case Node::WHILE: {
+            Expression::expr_ptr condition = expression();
+            Statement::stmt_ptr body = statement();
+            return std::make_shared<WhileStatement>(condition, body);
+        }
+        case Node::FOR: {
+            std::shared_ptr<VarStatement> initializer = as<VarStatement>(statement(), false);
+            Expression::expr_ptr condition = expression();
+            Expression::expr_ptr increment = expression();
+            Statement::stmt_ptr body = statement();
+            const Expression::expr_ptr bound = expression();
+            const Token comparison = token();
+            const std::int64_t step = get<std::int64_t>();
+
+            std::shared_ptr<Reduction> reduction;
+            if (get<std::uint8_t>())
+            {
+                const Token op = token();
+                const Token accumulator = token();
+                reduction = std::make_shared<Reduction>(Reduction{op, accumulator});
+                reduction->isGlobal = get<std::uint8_t>();
+            }
+
+            return std::make_shared<ForStatement>(initializer, condition, increment, body, bound, comparison, step,
+                                                  reduction);
+        }
+        case Node::BREAK:
+            return std::make_shared<BreakStatement>(token());
+        default:
+            throw std::runtime_error{"expected a statement"};
+        }
+    }
+
+    Expression::expr_ptr expression()
+    {
+        switch (get<Node>())
+        {
+        case Node::NONE:
+            return nullptr;
+
+        case Node::ASSIGN: {
+            const Token name = token();
+            Expression::expr_ptr value = expression();
+            std::shared_ptr<AssignExpression> assign = std::make_shared<AssignExpression>(name, value);
+            assign->_isGlobal = get<std::uint8_t>();
+            return assign;
+        }
+        case Node::BINARY: {
+            Expression::expr_ptr left = expression();
+            const Token op = token();
+            Expression::expr_ptr right = expression();
+            std::shared_ptr<BinaryExpression> binary = std::make_shared<BinaryExpression>(left, op, right);
+            binary->_unchecked = get<std::uint8_t>();
+            return binary;
+        }
+        case Node::CALL:
+            return call();
+        case Node::GET: {
+            Expression::expr_ptr object = expression();
+            const Token name = token();
+            return std::make_shared<GetExpression>(object, name);
+        }
+        case Node::GROUPING: {
+            Expression::expr_ptr expr = expression();
+            return std::make_shared<GroupingExpression>(expr);
+        }
+        case Node::INDEX: {
+            Expression::expr_ptr object = expression();
+            const Token bracket = token();
+            Expression::expr_ptr index = expression();
+            return std::make_shared<IndexExpression>(object, bracket, index);
+        }
+        case Node::INDEX_ASSIGN: {
+            Expression::expr_ptr object = expression();
+            const Token bracket = token();
+            Expression::expr_ptr index = expression();
+            Expression::expr_ptr value = expression();
+            return std::make_shared<IndexAssignExpression>(object, bracket, index, value);
+        }
+        case Node::LIST: {
+            Expression::expr_vec elements = expressions();
+            return std::make_shared<ListExpression>(elements);
+        }
+        case Node::LITERAL:
+            return std::make_shared<LiteralExpression>(literal());
+        case Node::LOGICAL: {
+            Expression::expr_ptr left = expression();
+            const Token op = token();
+            Expression::expr_ptr right = expression();
+            return std::make_shared<LogicalExpression>(left, op, right);
+        }
+        case Node::SET: {
+            Expression::expr_ptr object = expression();
+            const Token name = token();
+            Expression::expr_ptr value = expression();
+            return std::make_shared<SetExpression>(object, name, value);
+        }
+        case Node::SUPER: {
+            const Token keyword = token();
+            const Token method = token();
+            return std::make_shared<SuperExpression>(keyword, method);
+        }
+        case Node::THIS:
+            return std::make_shared<ThisExpression>(token());
+        case Node::UNARY: {
+            const Token op = token();
+            Expression::expr_ptr right = expression();
+            std::shared_ptr<UnaryExpression> unary = std::make_shared<UnaryExpression>(op, right);
+            unary->_unchecked = get<std::uint8_t>();
+            return unary;
+        }
+        case Node::VARIABLE: {
+            std::shared_ptr<VarExpression> var = std::make_shared<VarExpression>(token());
+            var->_isGlobal = get<std::uint8_t>();
+            return var;
+        }
+        case Node::INCREMENT: {
+            const Token name = token();
+            const Token op = token();
+            const literal_t delta = literal();
+            const bool isGlobal = get<std::uint8_t>();
+            const bool isUnchecked = get<std::uint8_t>();
+            return std::make_shared<IncrementExpression>(name, op, delta, isGlobal, isUnchecked);
+        }
+        case Node::COMPARE_CONST: {
+            const Token name = token();
+            const Token op = token();
+            const literal_t constant = literal();
+            const bool isGlobal = get<std::uint8_t>();
+            const bool isUnchecked = get<std::uint8_t>();
+            return std::make_shared<CompareConstExpression>(name, op, constant, isGlobal, isUnchecked);
+        }
+        case Node::ASSIGN_BINARY: {
+            const Token name = token();
+            const Token op = token();
+            Expression::expr_ptr right = expression();
+            const bool isGlobal = get<std::uint8_t>();
+            const bool isUnchecked = get<std::uint8_t>();
+            return std::make_shared<AssignBinaryExpression>(name, op, right, isGlobal, isUnchecked);
+        }
+        case Node::LITERAL_CALL: {
+            if (get<Node>() != Node::CALL)
+                throw std::runtime_error{"expected a call"};
+
+            const std::shared_ptr<CallExpression> inner = call();
+            std::vector<literal_t> args(get<std::uint32_t>());
+            for (literal_t &arg : args)
+                arg = literal();
+
+            return std::make_shared<LiteralCallExpression>(inner, args);
+        }
+        default:
+            throw std::runtime_error{"expected an expression"};
+        }
+    }
+
+  private:
+    void need(std::size_t bytes) const
+    {
+        if (static_cast<std::size_t>(_end - _pos) < bytes)
+            throw std::runtime_error{"truncated AST cache"};
+    }
+
+    template <typename T> T get()
+    {
+        need(sizeof(T));
+        T value;
+        std::memcpy(&value, _pos, sizeof(T));
+        _pos += sizeof(T);
+        return value;
+    }
+
+    const std::string &string()
+    {
+        return _strings.at(get<std::uint32_t>());
+    }
+
+    literal_t literal()
+    {
+        switch (get<Literal>())
+        {
+        case Literal::NIL:
+            return nullptr;
+        case Literal::STRING:
+            return string();
+        case Literal::NUMBER:
+            return get<double>();
+        case Literal::INT:
+            return get<std::int64_t>();
+        case Literal::BOOL:
+            return static_cast<bool>(get<std::uint8_t>());
+        default:
+            throw std::runtime_error{"unknown literal"};
+        }
+    }
+
+    Token token()
+    {
+        const TokenType type = static_cast<TokenType>(get<std::uint8_t>());
+        const std::string &lexeme = string();
+        literal_t value = literal();
+        return Token{type, lexeme, std::move(value), get<std::int32_t>()};
+    }
+
+    std::vector<Token> tokens()
+    {
+        const std::uint32_t count = get<std::uint32_t>();
+
+        std::vector<Token> tokens;
+        tokens.reserve(count);
+        for (std::uint32_t i = 0; i < count; ++i)
+            tokens.push_back(token());
+
+        return tokens;
+    }
+
+    Expression::expr_vec expressions()
+    {
+        Expression::expr_vec exprs(get<std::uint32_t>());
+        for (Expression::expr_ptr &expr : exprs)
+            expr = expression();
+
+        return exprs;
+    }
+
+    std::shared_ptr<CallExpression> call()
+    {
+        Expression::expr_ptr callee = expression();
+        const Token paren = token();
+        Expression::expr_vec args = expressions();
+        return std::make_shared<CallExpression>(callee, paren, args);
+    }
+
+    Statement::stmt_ptr function()
+    {
+        const Token name = token();
+        std::vector<Token> params = tokens();
+
+        if (!get<std::uint8_t>())
+        {
+            Statement::stmt_vec body = statements();
+            return std::make_shared<FunctionStatement>(name, params, body);
+        }
+
+        std::shared_ptr<LazyBody> lazy = std::make_shared<LazyBody>();
+        lazy->tokens = tokens();
+        for (std::uint32_t i = get<std::uint32_t>(); i > 0; --i)
+            lazy->assigned.insert(string());
+
+        return std::make_shared<FunctionStatement>(name, params, lazy);
+    }
+
+    template <typename T, typename Base> std::shared_ptr<T> as(const std::shared_ptr<Base> &node, bool optional)
+    {
+        std::shared_ptr<T> result = std::dynamic_pointer_cast<T>(node);
+        if (!result && (node || !optional))
+            throw std::runtime_error{"unexpected node"};
+
+        return result;
+    }
+
+    const char *_pos;
+    const char *const _end;
+    std::vector<std::string> _strings;
+};
+
+Statement::stmt_vec read(const char *data, std::size_t size, std::uint64_t hash, bool lazy)
+{
+    Header header;
+    if (size < sizeof(Header))
+        throw std::runtime_error{"no header"};
+
+    std::memcpy(&header, data, sizeof(Header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != AstCache::version ||
+        header.hash != hash || header.lazy != lazy)
+        throw std::runtime_error{"stale AST cache"};
+
+    Reader reader{data + sizeof(Header), data + size};
+    reader.readStrings(header.strings);
+    Statement::stmt_vec stmts = reader.statements();
+
+    if (!reader.atEnd())
+        throw std::runtime_error{"trailing bytes"};
+
+    return stmts;
+}
+} // namespace
+
+std::uint64_t lox::AstCache::hash(const std::string &sourceCode)
+{
+    // 64 bit FNV-1a
+    std::uint64_t hash = 14695981039346656037ull;
+    for (const char c : sourceCode)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+std::string lox::AstCache::path(const std::string &script, const std::string &cacheDir, std::uint64_t hash)
+{
+    if (cacheDir.empty())
+        return script + "c";
+
+    char name[24];
+    std::snprintf(name, sizeof(name), "%016llx.loxc", static_cast<unsigned long long>(hash));
+    return (std::filesystem::path{cacheDir} / name).string();
+}
+
+std::optional<Statement::stmt_vec> lox::AstCache::load(const std::string &path, std::uint64_t hash, bool lazy)
+{
+    try
+    {
+#ifdef _WIN32
+        std::ifstream file{path, std::ios::binary};
+        if (!file)
+            return std::nullopt;
+
+        const std::string data{std::istreambuf_iterator<char>{file}, {}};
+        return read(data.data(), data.size(), hash, lazy);
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return std::nullopt;
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || info.st_size == 0)
+        {
+            ::close(fd);
+            return std::nullopt;
+        }
+
+        const std::size_t size = info.st_size;
+        void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+
+        if (data == MAP_FAILED)
+            return std::nullopt;
+
+        try
+        {
+            Statement::stmt_vec stmts = read(static_cast<const char *>(data), size, hash, lazy);
+            ::munmap(data, size);
+            return stmts;
+        }
+        catch (...)
+        {
+            ::munmap(data, size);
+            throw;
+        }
+#endif
+    }
+    catch (const std::exception &)
+    {
+        return std::nullopt; // stale or corrupt, the caller parses the source again
+    }
+}
+
+bool lox::AstCache::store(const std::string &path, std::uint64_t hash, bool lazy, const Statement::stmt_vec &stmts)
+{
+    const std::optional<std::string> image = serialize(hash, lazy, stmts);
+    if (!image)
+        return false;
+
+    std::error_code error;
+    const std::filesystem::path target{path};
+    if (target.has_parent_path())
+        std::filesystem::create_directories(target.parent_path(), error);
+
+    // write to a temporary file first, concurrent runs never see a half written cache
+    const std::string temporary = temporaryPath(path);
+    {
+        std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+        if (!file)
+            return false;
+
+        file.write(image->data(), image->size());
+        if (!file)
+            return false;
+    }
+
+    std::filesystem::rename(temporary, target, error);
+    return !error;
+}
+
+std::optional<std::string> lox::AstCache::serialize(std::uint64_t hash, bool lazy, const Statement::stmt_vec &stmts)
+{
+    Writer writer;
+    try
+    {
+        writer.statements(stmts);
+    }
+    catch (const std::runtime_error &)
+    {
+        return std::nullopt;
+    }
+
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.hash = hash;
+    header.lazy = lazy;
+    header.strings = writer.strings().size();
+
+    std::string image{reinterpret_cast<const char *>(&header), sizeof(header)};
+    for (const std::string &str : writer.strings())
+    {
+        const std::uint32_t length = str.size();
+        image.append(reinterpret_cast<const char *>(&length), sizeof(length));
+        image.append(str);
+    }
+    image.append(writer.nodes());
+
+    return image;
+}
+
+Statement::stmt_vec lox::AstCache::deserialize(const std::string &image, std::uint64_t hash, bool lazy)
+{
+    return read(image.data(), image.size(), hash, lazy);
+}
@@ -0,0 +1,103 @@
+#include "../include/Batch.h"
+#include "../include/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+struct Result
+{
+    std::string out;
+    std::string err;
+    bool failed{false};
+    bool done{false};
+};
+
+std::vector<std::string> findScripts(const std::string &directory)
+{
+    std::vector<std::string> scripts;
+
+    std::error_code error;
+    for (std::filesystem::recursive_directory_iterator it{directory, error}, end; !error && it != end;
+         it.increment(error))
+    {
+        if (it->is_regular_file(error) && it->path().extension() == ".lox")
+            scripts.push_back(it->path().string());
+    }
+
+    if (error)
+        std::cerr << directory << ": " << error.message() << std::endl;
+
+    std::sort(scripts.begin(), scripts.end()); // the directory order isn't the same everywhere
+    return scripts;
+}
+} // namespace
+
+int lox::Batch::run()
+{
+    using clock = std::chrono::steady_clock;
+    const clock::time_point start = clock::now();
+
+    const std::vector<std::string> scripts = findScripts(_options.directory);
+    std::vector<Result> results(scripts.size());
+
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    ThreadPool pool{_options.threads};
+
+    // reading, compiling and running a script is one task, the scripts are independent of each other
+    for (std::size_t i = 0; i < scripts.size(); ++i)
+    {
+        pool.submit([&, i] {
+            std::ostringstream out;
+            std::ostringstream err;
+
+            Lox lox{_loxOptions, out, err};
+            const bool failed = !lox.runFile(std::string{scripts[i]});
+
+            const std::lock_guard lock{mutex};
+            results[i] = Result{out.str(), err.str(), failed, true};
+            finished.notify_one();
+        });
+    }
+
+    // print in order while the later scripts still run, the results are released once printed
+    std::size_t failures = 0;
+    for (std::size_t i = 0; i < scripts.size(); ++i)
+    {
+        Result result;
+        {
+            std::unique_lock lock{mutex};
+            finished.wait(lock, [&] { return results[i].done; });
+            result = std::move(results[i]);
+        }
+
+        std::cout << result.out;
+        std::cerr << result.err;
+
+        if (result.failed)
+        {
+            std::cerr << scripts[i] << ": failed" << std::endl;
+            ++failures;
+        }
+    }
+    std::cout.flush();
+
+    if (_loxOptions.report)
+    {
+        const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+        std::cerr << "batch: " << scripts.size() << " scripts, " << failures << " failed, " << seconds * 1000
+                  << " ms, " << (seconds > 0 ? scripts.size() / seconds : 0) << " scripts/s on " << pool.size()
+                  << " threads\n";
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,62 +1,60 @@
 #include "../include/types/Callables.h"
+#include "../include/Profiler.h"
 #include "../include/evaluating/Interpreter.h"
 #include "../include/types/Throwables.h"
-#include <chrono>
 
-lox::literal_t lox::ClockFunction::call(Interpreter &, const std::vector<literal_t> &) const
+namespace
 {
-    using namespace std::chrono;
+const lox::Token thisToken{lox::TokenType::THIS, "this", {}, 0};
+}
 
-    const auto timepoint = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
-    return timepoint / 1000.0;
+lox::literal_t lox::LoxFunction::call(Interpreter &interpreter, const std::vector<literal_t> &args,
+                                     const Token &paren) const
+{
+    return invoke(interpreter, args, std::make_shared<Environment>(_closure), paren);
 }
 
-lox::literal_t lox::LoxFunction::call(Interpreter &interpreter, const std::vector<literal_t> &args) const
+lox::literal_t lox::LoxFunction::callMethod(Interpreter &interpreter, const std::vector<literal_t> &args,
+                                            const std::shared_ptr<LoxInstance> &instance, const Token &paren) const
 {
+    // 'this' shares the environment with the parameters (can't clash, it's a keyword)
     Environment::environment_ptr env = std::make_shared<Environment>(_closure);
-    for (int i = 0; i < _declaration._params.size(); ++i)
-    {
-        const std::string varName = _declaration._params.at(i).lexeme;
-        env->define(varName, args.at(i));
-    }
-
-    try
-    {
-        interpreter.executeBlock(_declaration._body, env);
-    }
-    catch (const Return &e)
-    {
-        return e.value();
-    }
+    env->define(thisToken, instance);
 
-    return nullptr;
+    return invoke(interpreter, args, env, paren);
 }
 
-lox::literal_t lox::InputFunction::call(Interpreter &, const std::vector<literal_t> &) const
+lox::LoxCallable::callable_ptr lox::LoxFunction::bind(const std::shared_ptr<LoxInstance> &instance) const
 {
-    std::string input;
-    std::getline(std::cin, input);
-    return input;
+    Environment::environment_ptr env = std::make_shared<Environment>(_closure);
+    env->define(thisToken, instance);
+
+    return std::make_shared<LoxFunction>(_declaration, env, _isInitializer);
 }
 
-lox::literal_t lox::NumberFunction::call(Interpreter &interpreter, const std::vector<literal_t> &args) const
+lox::literal_t lox::LoxFunction::invoke(Interpreter &interpreter, const std::vector<literal_t> &args,
+                                        const Environment::environment_ptr &env, const Token &paren) const
 {
-    const literal_t value = args.at(0);
+    const Profiler::Frame frame{_declaration->_name.lexeme, paren.line};
+    const Statement::stmt_vec &body = _declaration->_lazy ? interpreter.lazyBody(*_declaration) : _declaration->_body;
 
-    if (std::holds_alternative<std::string>(value))
+    for (int i = 0; i < _declaration->_params.size(); ++i)
+        env->define(_declaration->_params.at(i), args.at(i));
+
+    try
     {
-        try
-        {
-            return std::stod(std::get<std::string>(value));
-        }
-        catch (std::exception &)
-        {
-            throw LoxRuntimeError{"Couldn't convert to a number.", *_lineToken};
-        }
+        interpreter.executeBlock(body, env);
     }
+    catch (const Return &e)
+    {
+        if (_isInitializer)
+            return env->get(thisToken);
 
-    if (std::holds_alternative<bool>(value))
-        return std::get<bool>(value) ? 1.0 : 0.0;
+        return e.value();
+    }
 
-    throw LoxRuntimeError{"Only strings and bools are convertable to numbers.", *_lineToken};
+    if (_isInitializer)
+        return env->get(thisToken);
+
+    return nullptr;
 }
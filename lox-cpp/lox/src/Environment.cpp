@@ -1,41 +1,134 @@
 #include "../include/evaluating/Environment.h"
+#include "../include/AST/Expressions.h"
 #include "../include/scanning/Token.h"
 #include "../include/types/Throwables.h"
+#include <atomic>
 
-lox::Environment::Environment(environment_ptr enclosing) : _enclosing{std::move(enclosing)}
+namespace
+{
+std::uint64_t nextStamp()
+{
+    // shared by every isolate, a stamp must never be handed out twice
+    static std::atomic<std::uint64_t> counter = 0;
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+} // namespace
+
+lox::Environment::Environment(environment_ptr enclosing) : _enclosing{std::move(enclosing)}, _stamp{nextStamp()}
 {
 }
 
 void lox::Environment::define(const std::string &name, const literal_t &value)
 {
-    // update value or add a new one
-    _values[name] = value;
+    define(hashName(name), name, value);
+}
+
+void lox::Environment::define(const Token &name, const literal_t &value)
+{
+    define(name.hash, name.lexeme, value);
+}
+
+void lox::Environment::defineAll(const Environment &other)
+{
+    for (const Binding &binding : other._values)
+        define(binding.hash, binding.name, binding.value);
 }
 
 void lox::Environment::assign(const Token &name, const literal_t &value)
 {
-    if (_values.contains(name.lexeme))
+    lookup(name) = value;
+}
+
+lox::literal_t lox::Environment::get(const Token &name)
+{
+    return lookup(name);
+}
+
+const lox::literal_t *lox::Environment::value(const std::string &name) const
+{
+    const std::uint32_t slot = find(hashName(name), name);
+    return slot != HashIndex::npos ? &_values[slot].value : nullptr;
+}
+
+const lox::literal_t &lox::Environment::getGlobal(const Token &name, GlobalCache &cache)
+{
+    return lookupGlobal(name, cache);
+}
+
+void lox::Environment::assignGlobal(const Token &name, const literal_t &value, GlobalCache &cache)
+{
+    lookupGlobal(name, cache) = value;
+}
+
+lox::literal_t &lox::Environment::lookup(const Token &name)
+{
+    for (Environment *env = this; env; env = env->_enclosing.get())
     {
-        _values[name.lexeme] = value;
-        return;
+        const std::uint32_t slot = env->find(name.hash, name.lexeme);
+        if (slot != HashIndex::npos)
+            return env->_values[slot].value;
     }
 
-    if (_enclosing)
+    throw LoxRuntimeError{"Undefined variable '" + name.lexeme + "'.", name};
+}
+
+lox::literal_t &lox::Environment::lookupGlobal(const Token &name, GlobalCache &cache)
+{
+    // slots never move, so the cached one stays valid until this scope gets a new variable
+    // (which could shadow the one found in an enclosing scope)
+    if (cache.stamp == _stamp)
+        return cache.owner->_values[cache.slot].value;
+
+    for (Environment *env = this; env; env = env->_enclosing.get())
     {
-        _enclosing->assign(name, value);
-        return;
+        const std::uint32_t slot = env->find(name.hash, name.lexeme);
+        if (slot != HashIndex::npos)
+        {
+            cache = GlobalCache{_stamp, env, slot};
+            return env->_values[slot].value;
+        }
     }
 
     throw LoxRuntimeError{"Undefined variable '" + name.lexeme + "'.", name};
 }
 
-lox::literal_t lox::Environment::get(const Token &name)
+// ---- private area -----
+
+void lox::Environment::define(std::size_t hash, const std::string &name, const literal_t &value)
 {
-    if (_values.contains(name.lexeme))
-        return _values.at(name.lexeme);
+    // update value or add a new one
+    const std::uint32_t slot = find(hash, name);
+    if (slot != HashIndex::npos)
+    {
+        _values[slot].value = value;
+        return;
+    }
 
-    if (_enclosing)
-        return _enclosing->get(name);
+    _values.push_back(Binding{hash, name, value});
+    _stamp = nextStamp(); // invalidates all global caches pointing into this scope
 
-    throw LoxRuntimeError{"Undefined variable '" + name.lexeme + "'.", name};
+    if (_values.size() > linearScanLimit)
+    {
+        if (_index.size() == 0) // scope just got too big, index everything
+        {
+            for (std::uint32_t i = 0; i < _values.size(); ++i)
+                _index.insert(_values[i].hash, i);
+        }
+        else
+            _index.insert(hash, static_cast<std::uint32_t>(_values.size() - 1));
+    }
+}
+
+std::uint32_t lox::Environment::find(std::size_t hash, const std::string &name) const
+{
+    if (_values.size() > linearScanLimit)
+        return _index.find(hash, [&](std::uint32_t slot) { return _values[slot].name == name; });
+
+    for (std::uint32_t i = 0; i < _values.size(); ++i)
+    {
+        if (_values[i].hash == hash && _values[i].name == name)
+            return i;
+    }
+
+    return HashIndex::npos;
 }
@@ -1,7 +1,4 @@
-#include <iostream>
-
 #include "../include/ErrorHandler.h"
-#include "../include/Lox.h"
 #include "../include/scanning/Token.h"
 #include "../include/types/Throwables.h"
 
@@ -23,12 +20,18 @@ void lox::ErrorHandler::error(const Token &token, const std::string &message)
 
 void lox::ErrorHandler::runtimeError(const LoxRuntimeError &e)
 {
-    std::cerr << e.what() << "\n[line " << e.token.line << "]\n";
-    Lox::hadRuntimeError = true;
+    _err << e.what() << "\n[line " << e.token.line << "]\n";
+    _hadRuntimeError = true;
 }
 
 void lox::ErrorHandler::report(int line, const std::string &where, const std::string &message)
 {
-    std::cerr << "[line " << line << "] Error" << where << ": " << message << "\n";
-    Lox::hadError = true;
+    _err << "[line " << line << "] Error" << where << ": " << message << "\n";
+    ++_errorCount;
+}
+
+void lox::ErrorHandler::reset()
+{
+    _errorCount = 0;
+    _hadRuntimeError = false;
 }
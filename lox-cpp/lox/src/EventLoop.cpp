@@ -0,0 +1,137 @@
+#include "../include/EventLoop.h"
+
+#ifdef __linux__
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <system_error>
+#include <unistd.h>
+
+lox::EventLoop::EventLoop()
+    : _epoll{epoll_create1(EPOLL_CLOEXEC)}, _wakeup{eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)}
+{
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = _wakeup;
+
+    if (_epoll < 0 || _wakeup < 0 || epoll_ctl(_epoll, EPOLL_CTL_ADD, _wakeup, &event) != 0)
+        throw std::system_error{errno, std::generic_category(), "event loop"};
+
+    _thread = std::thread{[this] { run(); }};
+}
+
+lox::EventLoop::~EventLoop()
+{
+    {
+        const std::lock_guard lock{_mutex};
+        _stopping = true;
+    }
+    wake();
+    _thread.join();
+
+    for (const std::coroutine_handle<> handle : _started)
+        handle.destroy();
+    for (const std::coroutine_handle<> handle : _ready)
+        handle.destroy();
+    for (const auto &[until, handle] : _timers)
+        handle.destroy();
+    for (const auto &[fd, handle] : _polling)
+        handle.destroy();
+
+    close(_wakeup);
+    close(_epoll);
+}
+
+void lox::EventLoop::start(Job job)
+{
+    {
+        const std::lock_guard lock{_mutex};
+        _started.push_back(job._handle);
+    }
+    wake();
+}
+
+// ---- private area -----
+
+void lox::EventLoop::run()
+{
+    std::array<epoll_event, 64> events;
+
+    for (;;)
+    {
+        {
+            const std::lock_guard lock{_mutex};
+            if (_stopping)
+                return;
+
+            _ready.insert(_ready.end(), _started.begin(), _started.end());
+            _started.clear();
+        }
+
+        // the jobs that are ready now, the ones that yield go again in the next round
+        for (std::size_t n = _ready.size(); n > 0; --n)
+        {
+            const std::coroutine_handle<> handle = _ready.front();
+            _ready.pop_front();
+            handle.resume();
+        }
+
+        int timeout = -1; // nothing to do but wait
+        if (!_ready.empty())
+            timeout = 0;
+        else if (!_timers.empty())
+        {
+            const auto left = std::chrono::ceil<std::chrono::milliseconds>(_timers.begin()->first - clock::now());
+            timeout = static_cast<int>(std::max<std::chrono::milliseconds::rep>(left.count(), 0));
+        }
+
+        const int count = epoll_wait(_epoll, events.data(), static_cast<int>(events.size()), timeout);
+        for (int i = 0; i < count; ++i) // none on errors, EINTR is the only one to expect
+        {
+            const int fd = events[i].data.fd;
+            if (fd == _wakeup)
+            {
+                std::uint64_t wakeups;
+                [[maybe_unused]] const ssize_t drained = read(_wakeup, &wakeups, sizeof wakeups);
+            }
+            else if (const auto polling = _polling.find(fd); polling != _polling.end())
+            {
+                _ready.push_back(polling->second);
+                _polling.erase(polling);
+            }
+        }
+
+        const clock::time_point now = clock::now();
+        while (!_timers.empty() && _timers.begin()->first <= now)
+        {
+            _ready.push_back(_timers.begin()->second);
+            _timers.erase(_timers.begin());
+        }
+    }
+}
+
+void lox::EventLoop::wake()
+{
+    const std::uint64_t one = 1;
+    [[maybe_unused]] const ssize_t written = write(_wakeup, &one, sizeof one);
+}
+
+bool lox::EventLoop::poll(int fd, std::coroutine_handle<> handle)
+{
+    // one shot, the descriptor stays registered (but disabled) for the next wait
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.fd = fd;
+
+    if (epoll_ctl(_epoll, EPOLL_CTL_MOD, fd, &event) != 0 &&
+        (errno != ENOENT || epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event) != 0))
+        return false; // EPERM for regular files
+
+    _polling[fd] = handle;
+    return true;
+}
+
+#endif
@@ -0,0 +1,121 @@
+#include "../include/evaluating/Fuser.h"
+#include "../include/types/Numbers.h"
+
+const char *lox::Fuser::name(Pattern pattern)
+{
+    switch (pattern)
+    {
+    case Pattern::INCREMENT:
+        return "increment";
+    case Pattern::COMPARE_CONST:
+        return "compare with constant";
+    case Pattern::ASSIGN_BINARY:
+        return "assign binary to self";
+    case Pattern::LITERAL_CALL:
+        return "call with literal arguments";
+    default:
+        return "";
+    }
+}
+
+// ----------- fuse expressions ------------
+
+void lox::Fuser::visitAssignExpr(const AssignExpression &expr)
+{
+    rewrite(expr._value);
+
+    // name = name op right
+    const BinaryExpression *binary = dynamic_cast<const BinaryExpression *>(expr._value.get());
+    if (!binary)
+        return;
+
+    const VarExpression *self = dynamic_cast<const VarExpression *>(binary->_left.get());
+    if (!self || self->_name.lexeme != expr._name.lexeme)
+        return;
+
+    using enum TokenType;
+    const TokenType op = binary->_operator.type;
+    if (op != PLUS && op != MINUS && op != STAR && op != SLASH)
+        return;
+
+    const LiteralExpression *literal = dynamic_cast<const LiteralExpression *>(binary->_right.get());
+    if ((op == PLUS || op == MINUS) && literal && isNumber(literal->_value))
+    {
+        replaceWith(Pattern::INCREMENT,
+                    std::make_shared<IncrementExpression>(expr._name, binary->_operator, literal->_value,
+                                                          expr._isGlobal, binary->_unchecked));
+        return;
+    }
+
+    if (hasNoSideEffects(*binary->_right))
+    {
+        Expression::expr_ptr right = binary->_right;
+        replaceWith(Pattern::ASSIGN_BINARY, std::make_shared<AssignBinaryExpression>(
+                                                expr._name, binary->_operator, right, expr._isGlobal,
+                                                binary->_unchecked));
+    }
+}
+
+void lox::Fuser::visitBinaryExpr(const BinaryExpression &expr)
+{
+    rewrite(expr._left);
+    rewrite(expr._right);
+
+    // name op constant
+    const VarExpression *var = dynamic_cast<const VarExpression *>(expr._left.get());
+    const LiteralExpression *constant = dynamic_cast<const LiteralExpression *>(expr._right.get());
+    if (!var || !constant)
+        return;
+
+    using enum TokenType;
+
+    switch (expr._operator.type)
+    {
+    case GREATER:
+    case GREATER_EQUAL:
+    case LESS:
+    case LESS_EQUAL:
+        if (!isNumber(constant->_value))
+            return; // always a runtime error, leave it to the generic path
+        break;
+    case EQUAL_EQUAL:
+    case BANG_EQUAL:
+        break;
+    default:
+        return;
+    }
+
+    replaceWith(Pattern::COMPARE_CONST,
+                std::make_shared<CompareConstExpression>(var->_name, expr._operator, constant->_value, var->_isGlobal,
+                                                         expr._unchecked));
+}
+
+void lox::Fuser::visitCallExpr(const CallExpression &expr)
+{
+    const Expression::expr_ptr self = current(); // rewriting the children changes it
+
+    rewrite(expr._callee);
+
+    std::vector<literal_t> literals;
+    for (const Expression::expr_ptr &arg : expr._args)
+    {
+        rewrite(arg);
+
+        if (const LiteralExpression *literal = dynamic_cast<const LiteralExpression *>(arg.get()))
+            literals.push_back(literal->_value);
+    }
+
+    if (!literals.empty() && literals.size() == expr._args.size())
+    {
+        replaceWith(Pattern::LITERAL_CALL,
+                    std::make_shared<LiteralCallExpression>(std::static_pointer_cast<CallExpression>(self), literals));
+    }
+}
+
+// ---- private area -----
+
+void lox::Fuser::replaceWith(Pattern pattern, Expression::expr_ptr fused)
+{
+    Rewriter::replaceWith(std::move(fused));
+    ++_hits[static_cast<std::size_t>(pattern)];
+}
@@ -0,0 +1,58 @@
+#include "../include/types/HashIndex.h"
+#include <utility>
+
+void lox::HashIndex::insert(std::size_t hash, std::uint32_t slot)
+{
+    // keep the load factor below 7/8, robin hood probing stays short up to there
+    if ((_size + 1) * 8 > _buckets.size() * 7)
+        grow();
+
+    place(Bucket{static_cast<std::uint32_t>(hash), slot});
+    ++_size;
+}
+
+void lox::HashIndex::clear()
+{
+    _buckets.clear();
+    _mask = 0;
+    _size = 0;
+}
+
+void lox::HashIndex::place(Bucket incoming)
+{
+    std::size_t pos = incoming.hash & _mask;
+
+    for (std::size_t dist = 0;; pos = (pos + 1) & _mask, ++dist)
+    {
+        Bucket &bucket = _buckets[pos];
+        if (bucket.slot == npos)
+        {
+            bucket = incoming;
+            return;
+        }
+
+        // take the place of residents that are closer to their home bucket
+        const std::size_t residentDist = distance(bucket, pos);
+        if (residentDist < dist)
+        {
+            std::swap(bucket, incoming);
+            dist = residentDist;
+        }
+    }
+}
+
+void lox::HashIndex::grow()
+{
+    std::vector<Bucket> old = std::move(_buckets);
+
+    const std::size_t capacity = old.empty() ? 16 : old.size() * 2;
+    _buckets.assign(capacity, Bucket{0, npos});
+    _mask = capacity - 1;
+
+    // the short hash is enough to find the new position, no need to touch the entries
+    for (const Bucket &bucket : old)
+    {
+        if (bucket.slot != npos)
+            place(bucket);
+    }
+}
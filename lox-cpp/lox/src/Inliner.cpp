@@ -0,0 +1,255 @@
+#include "../include/evaluating/Inliner.h"
+
+namespace
+{
+using namespace lox;
+
+// checks, that the expression can be copied into a call site, counts its nodes and the uses of the parameters.
+// parameters used where and/or may skip them are marked skippable, their arguments wouldn't always be evaluated
+bool measure(const Expression &expr, const std::vector<Token> &params, std::vector<std::size_t> &uses,
+             std::vector<bool> &skippable, std::size_t &size, bool skipped = false)
+{
+    ++size;
+
+    if (dynamic_cast<const LiteralExpression *>(&expr))
+        return true;
+
+    if (const VarExpression *var = dynamic_cast<const VarExpression *>(&expr))
+    {
+        if (var->_isGlobal)
+            return true;
+
+        for (std::size_t i = 0; i < params.size(); ++i)
+        {
+            if (params[i].lexeme == var->_name.lexeme)
+            {
+                ++uses[i];
+                if (skipped)
+                    skippable[i] = true;
+            }
+        }
+        return true;
+    }
+
+    const auto inner = [&](const Expression &operand, bool maybeSkipped) {
+        return measure(operand, params, uses, skippable, size, skipped || maybeSkipped);
+    };
+
+    if (const GroupingExpression *grouping = dynamic_cast<const GroupingExpression *>(&expr))
+        return inner(*grouping->_expression, false);
+    if (const UnaryExpression *unary = dynamic_cast<const UnaryExpression *>(&expr))
+        return inner(*unary->_right, false);
+    if (const BinaryExpression *binary = dynamic_cast<const BinaryExpression *>(&expr))
+        return inner(*binary->_left, false) && inner(*binary->_right, false);
+    if (const LogicalExpression *logical = dynamic_cast<const LogicalExpression *>(&expr))
+        return inner(*logical->_left, false) && inner(*logical->_right, true);
+    if (const GetExpression *get = dynamic_cast<const GetExpression *>(&expr))
+        return inner(*get->_object, false);
+    if (const IndexExpression *index = dynamic_cast<const IndexExpression *>(&expr))
+        return inner(*index->_object, false) && inner(*index->_index, false);
+
+    return false; // calls, assignments, ...
+}
+
+Expression::expr_ptr copyVariable(const VarExpression &var)
+{
+    std::shared_ptr<VarExpression> copy = std::make_shared<VarExpression>(var._name);
+    copy->_isGlobal = var._isGlobal;
+    return copy;
+}
+
+// argument of a call site, the call itself goes away
+Expression::expr_ptr copyArgument(const Expression::expr_ptr &arg)
+{
+    if (const VarExpression *var = dynamic_cast<const VarExpression *>(arg.get()))
+        return copyVariable(*var);
+
+    return arg; // a literal (never changed) or an expression that is used once, they can be moved
+}
+
+// copy of the function body with the parameters replaced by the arguments,
+// every node is new, the passes after this one keep their marks on them
+Expression::expr_ptr substitute(const Expression &expr, const std::vector<Token> &params,
+                                const Expression::expr_vec &args)
+{
+    if (const LiteralExpression *literal = dynamic_cast<const LiteralExpression *>(&expr))
+        return std::make_shared<LiteralExpression>(literal->_value);
+
+    if (const VarExpression *var = dynamic_cast<const VarExpression *>(&expr))
+    {
+        if (!var->_isGlobal)
+        {
+            for (std::size_t i = 0; i < params.size(); ++i)
+            {
+                if (params[i].lexeme == var->_name.lexeme)
+                    return copyArgument(args[i]);
+            }
+        }
+        return copyVariable(*var);
+    }
+
+    if (const GroupingExpression *grouping = dynamic_cast<const GroupingExpression *>(&expr))
+    {
+        Expression::expr_ptr inner = substitute(*grouping->_expression, params, args);
+        return std::make_shared<GroupingExpression>(inner);
+    }
+    if (const UnaryExpression *unary = dynamic_cast<const UnaryExpression *>(&expr))
+    {
+        Expression::expr_ptr right = substitute(*unary->_right, params, args);
+        return std::make_shared<UnaryExpression>(unary->_operator, right);
+    }
+    if (const BinaryExpression *binary = dynamic_cast<const BinaryExpression *>(&expr))
+    {
+        Expression::expr_ptr left = substitute(*binary->_left, params, args);
+        Expression::expr_ptr right = substitute(*binary->_right, params, args);
+        return std::make_shared<BinaryExpression>(left, binary->_operator, right);
+    }
+    if (const LogicalExpression *logical = dynamic_cast<const LogicalExpression *>(&expr))
+    {
+        Expression::expr_ptr left = substitute(*logical->_left, params, args);
+        Expression::expr_ptr right = substitute(*logical->_right, params, args);
+        return std::make_shared<LogicalExpression>(left, logical->_operator, right);
+    }
+    if (const GetExpression *get = dynamic_cast<const GetExpression *>(&expr))
+    {
+        Expression::expr_ptr object = substitute(*get->_object, params, args);
+        return std::make_shared<GetExpression>(object, get->_name);
+    }
+
+    const IndexExpression &index = dynamic_cast<const IndexExpression &>(expr); // the last one measure() accepts
+    Expression::expr_ptr object = substitute(*index._object, params, args);
+    Expression::expr_ptr position = substitute(*index._index, params, args);
+    return std::make_shared<IndexExpression>(object, index._bracket, position);
+}
+} // namespace
+
+void lox::Inliner::inlineCalls(const Statement::stmt_vec &stmts)
+{
+    // a global can be redeclared at the top level or assigned from anywhere
+    for (const Statement::stmt_ptr &stmt : stmts)
+    {
+        if (const VarStatement *var = dynamic_cast<const VarStatement *>(stmt.get()))
+            ++_declarations[var->_name.lexeme];
+        else if (const FunctionStatement *fun = dynamic_cast<const FunctionStatement *>(stmt.get()))
+            ++_declarations[fun->_name.lexeme];
+        else if (const ClassStatement *klass = dynamic_cast<const ClassStatement *>(stmt.get()))
+            ++_declarations[klass->_name.lexeme];
+    }
+
+    _collecting = true;
+    rewrite(stmts);
+    _collecting = false;
+
+    // the body of a function is rewritten before it becomes a candidate itself, so it can use the functions
+    // declared above it but never itself
+    for (const Statement::stmt_ptr &stmt : stmts)
+    {
+        rewrite(stmt);
+
+        if (const FunctionStatement *fun = dynamic_cast<const FunctionStatement *>(stmt.get()))
+            addCandidate(*fun);
+    }
+}
+
+std::size_t lox::Inliner::inlinedCalls() const
+{
+    std::size_t count = 0;
+    for (const auto &[name, calls] : _inlined)
+        count += calls;
+
+    return count;
+}
+
+// ----------- rewrite statements ------------
+
+void lox::Inliner::visitFunctionStatement(const FunctionStatement &stmt)
+{
+    // a lazy body isn't parsed yet, it could assign any of the names assigned in it
+    if (_collecting && stmt._lazy)
+        _assigned.insert(stmt._lazy->assigned.begin(), stmt._lazy->assigned.end());
+
+    Rewriter::visitFunctionStatement(stmt);
+}
+
+// ----------- rewrite expressions ------------
+
+void lox::Inliner::visitAssignExpr(const AssignExpression &expr)
+{
+    Rewriter::visitAssignExpr(expr);
+
+    if (_collecting && expr._isGlobal)
+        _assigned.insert(expr._name.lexeme);
+}
+
+void lox::Inliner::visitCallExpr(const CallExpression &expr)
+{
+    Rewriter::visitCallExpr(expr);
+
+    if (_collecting)
+        return;
+
+    const VarExpression *callee = dynamic_cast<const VarExpression *>(expr._callee.get());
+    if (!callee || !callee->_isGlobal)
+        return;
+
+    const auto it = _candidates.find(callee->_name.lexeme);
+    if (it == _candidates.end())
+        return;
+
+    const Candidate &candidate = it->second;
+    if (expr._args.size() != candidate.function->_params.size())
+        return; // leave the error to the runtime
+
+    // the arguments are evaluated where the parameters are used, that's only the same as evaluating them before the
+    // call, if they have no side effects. they still could fail (undefined variable, wrong operand types), so they
+    // have to be evaluated at least once, and bigger ones exactly once to not grow the code
+    for (std::size_t i = 0; i < expr._args.size(); ++i)
+    {
+        const Expression *arg = expr._args[i].get();
+        if (dynamic_cast<const LiteralExpression *>(arg))
+            continue;
+
+        // used only where and/or may skip it (k(true, undefined) with return a or b;)
+        if (candidate.skippable[i])
+            return;
+
+        if (dynamic_cast<const VarExpression *>(arg))
+        {
+            if (candidate.uses[i] == 0)
+                return;
+            continue;
+        }
+
+        std::vector<std::size_t> none;
+        std::vector<bool> noneSkippable;
+        std::size_t size = 0;
+        if (candidate.uses[i] != 1 || !measure(*arg, {}, none, noneSkippable, size))
+            return;
+    }
+
+    replaceWith(substitute(*candidate.body, candidate.function->_params, expr._args));
+    ++_inlined[candidate.index].second;
+}
+
+// ---- private area -----
+
+void lox::Inliner::addCandidate(const FunctionStatement &function)
+{
+    const std::string &name = function._name.lexeme;
+    if (_declarations[name] != 1 || _assigned.contains(name) || function._body.size() != 1)
+        return;
+
+    const ReturnStatement *ret = dynamic_cast<const ReturnStatement *>(function._body.front().get());
+    if (!ret || !ret->_value)
+        return;
+
+    std::vector<std::size_t> uses(function._params.size(), 0);
+    std::vector<bool> skippable(function._params.size(), false);
+    std::size_t size = 0;
+    if (!measure(*ret->_value, function._params, uses, skippable, size) || size > maxBodySize)
+        return;
+
+    _candidates.emplace(name,
+                        Candidate{&function, ret->_value.get(), std::move(uses), std::move(skippable), _inlined.size()});
+    _inlined.emplace_back(name, 0);
+}
@@ -1,25 +1,47 @@
 #include "../include/evaluating/Interpreter.h"
 #include "../include/AST/Statements.h"
 #include "../include/ErrorHandler.h"
+#include "../include/Program.h"
+#include "../include/evaluating/Fuser.h"
+#include "../include/evaluating/Resolver.h"
+#include "../include/evaluating/TypeInference.h"
+#include "../include/parsing/AstCache.h"
+#include "../include/parsing/Parser.h"
 #include "../include/types/Callables.h"
+#include "../include/types/LoxClass.h"
+#include "../include/types/LoxList.h"
+#include "../include/types/LoxMap.h"
+#include "../include/types/LoxTask.h"
+#include "../include/types/Natives.h"
+#include "../include/types/Numbers.h"
 #include "../include/types/Throwables.h"
 #include "../include/types/TokenType.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <variant>
+
+namespace
+{
+lox::Token keywordToken(lox::TokenType type, const std::string &lexeme, int line)
+{
+    return lox::Token{type, lexeme, {}, line};
+}
+} // namespace
 
 // ---------------------------------
 
-lox::Interpreter::Interpreter() : _globals{std::make_shared<Environment>()}
+lox::Interpreter::Interpreter(std::ostream &out, ErrorHandler &errors)
+    : _out{out}, _errors{errors}, _globals{std::make_shared<Environment>()}, _environment{_globals}
 {
-    // define native functions
-    _globals->define("clock", std::make_shared<ClockFunction>());
-    _globals->define("input", std::make_shared<InputFunction>());
-    _globals->define("number", std::make_shared<NumberFunction>());
-
-    // copy content to environment
-    _environment = std::make_shared<Environment>(*_globals);
+    defineNatives(*_globals);
 }
 
-void lox::Interpreter::interpret(const Statement::stmt_vec &stmts)
+void lox::Interpreter::interpret(const Statement::stmt_vec &stmts, std::shared_ptr<const Program> program)
 {
+    const Statement::stmt_vec *const running = std::exchange(_running, &stmts);
+    std::shared_ptr<const Program> previous = std::exchange(_program, std::move(program));
+
     try
     {
         for (const Statement::stmt_ptr &statement : stmts)
@@ -29,12 +51,47 @@ void lox::Interpreter::interpret(const Statement::stmt_vec &stmts)
     }
     catch (const LoxRuntimeError &e)
     {
-        ErrorHandler::runtimeError(e);
+        _errors.runtimeError(e);
     }
     catch (const Return &e)
     {
-        ErrorHandler::error(e.keyword(), "Cannot return outside of a function/method.");
+        _errors.error(e.keyword(), "Cannot return outside of a function/method.");
+    }
+
+    _running = running;
+    _program = std::move(previous);
+}
+
+void lox::Interpreter::declare(const Statement::stmt_vec &stmts, std::shared_ptr<const Program> program)
+{
+    _running = &stmts;
+    _program = std::move(program);
+
+    for (const Statement::stmt_ptr &statement : stmts)
+    {
+        if (dynamic_cast<const FunctionStatement *>(statement.get()) ||
+            dynamic_cast<const ClassStatement *>(statement.get()))
+            statement->accept(*this);
+    }
+}
+
+std::shared_ptr<const lox::Program> lox::Interpreter::program()
+{
+    if (!_program && _running)
+    {
+        // the analyzed AST as it is now, lazy bodies that ran already go in parsed
+        if (std::optional<std::string> image = AstCache::serialize(0, false, *_running))
+            _program = std::make_shared<const Program>(std::move(*image), 0, false);
     }
+
+    return _program;
+}
+
+void lox::Interpreter::resetGlobals(const Environment &snapshot)
+{
+    _globals = std::make_shared<Environment>();
+    _globals->defineAll(snapshot);
+    _environment = _globals;
 }
 
 std::string lox::Interpreter::toString()
@@ -44,6 +101,9 @@ std::string lox::Interpreter::toString()
     if (holds_alternative<nullptr_t>(_resultingLiteral))
         return "nil";
 
+    if (holds_alternative<int64_t>(_resultingLiteral))
+        return to_string(get<int64_t>(_resultingLiteral));
+
     if (holds_alternative<double>(_resultingLiteral))
     {
         string strNum = to_string(get<double>(_resultingLiteral));
@@ -65,6 +125,51 @@ std::string lox::Interpreter::toString()
         return get<string>(_resultingLiteral);
     if (holds_alternative<bool>(_resultingLiteral))
         return get<bool>(_resultingLiteral) ? "true" : "false";
+    if (holds_alternative<LoxCallable::callable_ptr>(_resultingLiteral))
+        return get<LoxCallable::callable_ptr>(_resultingLiteral)->toString();
+
+    if (holds_alternative<LoxList::list_ptr>(_resultingLiteral))
+    {
+        const LoxList::list_ptr list = get<LoxList::list_ptr>(_resultingLiteral);
+
+        // a list that contains itself (or a map that contains it)
+        if (std::find(_printing.begin(), _printing.end(), list.get()) != _printing.end())
+            return "[...]";
+        _printing.push_back(list.get());
+
+        string str = "[";
+        for (std::size_t i = 0; i < list->size(); ++i)
+        {
+            if (i > 0)
+                str += ", ";
+            str += toString(list->get(i));
+        }
+
+        _printing.pop_back();
+        return str + "]";
+    }
+
+    if (holds_alternative<LoxInstance::instance_ptr>(_resultingLiteral))
+        return get<LoxInstance::instance_ptr>(_resultingLiteral)->toString();
+
+    if (holds_alternative<LoxMap::map_ptr>(_resultingLiteral))
+    {
+        const LoxMap::map_ptr map = get<LoxMap::map_ptr>(_resultingLiteral);
+
+        if (std::find(_printing.begin(), _printing.end(), map.get()) != _printing.end())
+            return "{...}";
+        _printing.push_back(map.get());
+
+        string str = "{";
+        map->forEach([&](const literal_t &key, const literal_t &value) {
+            if (str.length() > 1)
+                str += ", ";
+            str += toString(key) + ": " + toString(value);
+        });
+
+        _printing.pop_back();
+        return str + "}";
+    }
 }
 
 std::string lox::Interpreter::toString(const literal_t &val)
@@ -78,6 +183,8 @@ std::string lox::Interpreter::toString(const literal_t &val)
 
 void lox::Interpreter::visitIfStmt(const IfStatement &stmt)
 {
+    LOX_PROFILE_STATEMENT(stmt);
+
     literal_t evaluatedCondition = getLiteral(stmt._condition);
 
     if (isTruthy(evaluatedCondition))
@@ -91,38 +198,86 @@ void lox::Interpreter::visitBlockStmt(const BlockStatement &stmt)
     executeBlock(stmt._statements, std::make_shared<Environment>(_environment));
 }
 
+void lox::Interpreter::visitClassStmt(const ClassStatement &stmt)
+{
+    LOX_PROFILE_STATEMENT(stmt);
+
+    LoxClass::class_ptr superclass;
+    if (stmt._superclass)
+    {
+        const literal_t value = getLiteral(stmt._superclass);
+        if (std::holds_alternative<LoxCallable::callable_ptr>(value))
+            superclass = std::dynamic_pointer_cast<LoxClass>(std::get<LoxCallable::callable_ptr>(value));
+
+        if (!superclass)
+            throw LoxRuntimeError("Superclass must be a class.", stmt._superclass->_name);
+    }
+
+    _environment->define(stmt._name, nullptr);
+
+    // methods of subclasses find their superclass as 'super' in an extra scope
+    Environment::environment_ptr closure = _environment;
+    if (superclass)
+    {
+        closure = std::make_shared<Environment>(_environment);
+        closure->define(keywordToken(TokenType::SUPER, "super", stmt._name.line), superclass);
+    }
+
+    LoxClass::method_map methods;
+    for (const ClassStatement::function_ptr &method : stmt._methods)
+    {
+        const bool isInitializer = method->_name.lexeme == "init";
+        methods[method->_name.lexeme] = std::make_shared<LoxFunction>(method, closure, isInitializer);
+    }
+
+    LoxCallable::callable_ptr klass = std::make_shared<LoxClass>(stmt._name.lexeme, superclass, methods);
+    _environment->assign(stmt._name, klass);
+}
+
 void lox::Interpreter::visitExpressionStmt(const ExpressionStatement &stmt)
 {
+    LOX_PROFILE_STATEMENT(stmt);
+
     stmt._expr->accept(*this);
 }
 
 void lox::Interpreter::visitFunctionStatement(const FunctionStatement &stmt)
 {
-    LoxCallable::callable_ptr function = std::make_shared<LoxFunction>(stmt, _environment);
-    _environment->define(stmt._name.lexeme, function);
+    LOX_PROFILE_STATEMENT(stmt);
+
+    // the declaration gets copied, because the statement might not outlive the function (prompt mode)
+    LoxCallable::callable_ptr function =
+        std::make_shared<LoxFunction>(std::make_shared<FunctionStatement>(stmt), _environment);
+    _environment->define(stmt._name, function);
 }
 
 void lox::Interpreter::visitVarStmt(const VarStatement &stmt)
 {
+    LOX_PROFILE_STATEMENT(stmt);
+
     literal_t value;
     if (stmt._initializer)
         value = getLiteral(stmt._initializer);
 
     // save variable
-    _environment->define(stmt._name.lexeme, value);
+    _environment->define(stmt._name, value);
 }
 
 void lox::Interpreter::visitPrintStmt(const PrintStatement &stmt)
 {
+    LOX_PROFILE_STATEMENT(stmt);
+
     // get literal in form of a string
     stmt._expr->accept(*this);
     const std::string strLiteral = toString();
 
-    std::cout << strLiteral << "\n";
+    _out << strLiteral << "\n";
 }
 
 void lox::Interpreter::visitReturnStmt(const ReturnStatement &stmt)
 {
+    LOX_PROFILE_STATEMENT(stmt);
+
     literal_t val;
     if (stmt._value)
         val = getLiteral(stmt._value);
@@ -132,6 +287,8 @@ void lox::Interpreter::visitReturnStmt(const ReturnStatement &stmt)
 
 void lox::Interpreter::visitWhileStmt(const WhileStatement &stmt)
 {
+    LOX_PROFILE_STATEMENT(stmt);
+
     try
     {
         while (isTruthy(getLiteral(stmt._condition)))
@@ -145,8 +302,42 @@ void lox::Interpreter::visitWhileStmt(const WhileStatement &stmt)
     }
 }
 
-void lox::Interpreter::visitBreakStmt(const BreakStatement &)
+void lox::Interpreter::visitForStmt(const ForStatement &stmt)
+{
+    LOX_PROFILE_STATEMENT(stmt);
+
+    if (stmt._reduction)
+    {
+        runParallelLoop(stmt);
+        return;
+    }
+
+    // the counter lives in its own scope, shared by all iterations (like the desugared block)
+    Environment::environment_ptr outer = _environment;
+    _environment = std::make_shared<Environment>(outer);
+
+    try
+    {
+        stmt._initializer->accept(*this);
+        runCountedLoop(stmt);
+    }
+    catch (const Break &)
+    {
+        // for statement is now cancelled
+    }
+    catch (...)
+    {
+        _environment = outer;
+        throw;
+    }
+
+    _environment = outer;
+}
+
+void lox::Interpreter::visitBreakStmt([[maybe_unused]] const BreakStatement &stmt)
 {
+    LOX_PROFILE_STATEMENT(stmt);
+
     throw Break{}; // gets catched in a while loop
 }
 
@@ -155,7 +346,11 @@ void lox::Interpreter::visitBreakStmt(const BreakStatement &)
 void lox::Interpreter::visitAssignExpr(const AssignExpression &expr)
 {
     literal_t value = getLiteral(expr._value); // evaluate expression
-    _environment->assign(expr._name, value);
+
+    if (expr._isGlobal)
+        _globals->assignGlobal(expr._name, value, expr._cache);
+    else
+        _environment->assign(expr._name, value);
 
     _resultingLiteral = value; // just to be sure
 }
@@ -165,86 +360,82 @@ void lox::Interpreter::visitBinaryExpr(const BinaryExpression &expr)
     literal_t left = getLiteral(expr._left);
     literal_t right = getLiteral(expr._right);
 
-    using enum TokenType;
-    using namespace std;
+    _resultingLiteral = evaluateBinary(expr._operator, left, right, expr._unchecked);
+}
 
-    switch (expr._operator.type)
-    {
-    case GREATER:
-        checkOperand(expr._operator, left, right);
-        _resultingLiteral = get<double>(left) > get<double>(right);
-        break;
-    case GREATER_EQUAL:
-        checkOperand(expr._operator, left, right);
-        _resultingLiteral = get<double>(left) >= get<double>(right);
-        break;
-    case LESS:
-        checkOperand(expr._operator, left, right);
-        _resultingLiteral = get<double>(left) < get<double>(right);
-        break;
-    case LESS_EQUAL:
-        checkOperand(expr._operator, left, right);
-        _resultingLiteral = get<double>(left) <= get<double>(right);
-        break;
-    case EQUAL_EQUAL:
-        _resultingLiteral = isEqual(left, right);
-        break;
-    case BANG_EQUAL:
-        _resultingLiteral = !isEqual(left, right);
-        break;
-    case MINUS:
-        checkOperand(expr._operator, left, right);
-        _resultingLiteral = get<double>(left) - get<double>(right);
-        break;
-    case PLUS:
-        evaluatePlus(left, right, expr._operator);
-        break;
-    case SLASH:
-        checkOperand(expr._operator, left, right);
+void lox::Interpreter::visitCallExpr(const CallExpression &expr)
+{
+    evaluateCall(expr, nullptr);
+}
 
-        if (get<double>(right) == 0)
-            throw LoxRuntimeError("Can't divide by 0.", expr._operator);
+void lox::Interpreter::visitGetExpr(const GetExpression &expr)
+{
+    const LoxInstance::instance_ptr instance =
+        checkInstance(expr._name, getLiteral(expr._object), "Only instances have properties.");
 
-        _resultingLiteral = get<double>(left) / get<double>(right);
-        break;
-    case STAR:
-        checkOperand(expr._operator, left, right);
-        _resultingLiteral = get<double>(left) * get<double>(right);
-        break;
-    default:
-        _resultingLiteral = nullptr;
-    }
+    _resultingLiteral = instance->get(expr._name, expr._cache);
 }
 
-void lox::Interpreter::visitCallExpr(const CallExpression &expr)
+void lox::Interpreter::visitGroupingExpr(const GroupingExpression &expr)
 {
-    literal_t callee = getLiteral(expr._callee);
+    expr._expression->accept(*this);
+}
 
-    std::vector<literal_t> arguments;
-    for (const Expression::expr_ptr arg : expr._args)
+void lox::Interpreter::visitIndexExpr(const IndexExpression &expr)
+{
+    const literal_t object = getLiteral(expr._object);
+    const literal_t index = getLiteral(expr._index);
+
+    if (std::holds_alternative<LoxMap::map_ptr>(object))
     {
-        literal_t evaluated = getLiteral(arg);
-        arguments.push_back(std::move(evaluated));
+        checkKey(expr._bracket, index);
+
+        // missing keys evaluate to nil
+        const literal_t *value = std::get<LoxMap::map_ptr>(object)->get(index);
+        _resultingLiteral = value ? *value : nullptr;
+        return;
     }
 
-    if (!std::holds_alternative<LoxCallable::callable_ptr>(callee))
-        throw LoxRuntimeError("Can only call functions and classes.", expr._paren);
+    if (!std::holds_alternative<LoxList::list_ptr>(object))
+        throw LoxRuntimeError("Only lists and maps can be indexed.", expr._bracket);
 
-    LoxCallable::callable_ptr function = std::get<LoxCallable::callable_ptr>(callee);
-    if (arguments.size() != function->arity())
+    const LoxList &list = *std::get<LoxList::list_ptr>(object);
+    _resultingLiteral = list.get(checkIndex(expr._bracket, list, index));
+}
+
+void lox::Interpreter::visitIndexAssignExpr(const IndexAssignExpression &expr)
+{
+    const literal_t object = getLiteral(expr._object);
+    const literal_t index = getLiteral(expr._index);
+    literal_t value = getLiteral(expr._value);
+
+    if (std::holds_alternative<LoxMap::map_ptr>(object))
     {
-        const std::string msg = "Expected " + std::to_string(function->arity()) + " arguments but got " +
-                                std::to_string(arguments.size()) + ".";
-        throw LoxRuntimeError(msg, expr._paren);
+        checkKey(expr._bracket, index);
+        std::get<LoxMap::map_ptr>(object)->set(index, value);
+
+        _resultingLiteral = std::move(value);
+        return;
     }
 
-    function->setLineToken(expr._paren); // for error reports inside the call() method
-    _resultingLiteral = function->call(*this, std::move(arguments));
+    if (!std::holds_alternative<LoxList::list_ptr>(object))
+        throw LoxRuntimeError("Only lists and maps can be indexed.", expr._bracket);
+
+    LoxList &list = *std::get<LoxList::list_ptr>(object);
+    list.set(checkIndex(expr._bracket, list, index), value);
+
+    _resultingLiteral = std::move(value);
 }
 
-void lox::Interpreter::visitGroupingExpr(const GroupingExpression &expr)
+void lox::Interpreter::visitListExpr(const ListExpression &expr)
 {
-    expr._expression->accept(*this);
+    std::vector<literal_t> elements;
+    elements.reserve(expr._elements.size());
+
+    for (const Expression::expr_ptr &element : expr._elements)
+        elements.push_back(getLiteral(element));
+
+    _resultingLiteral = std::make_shared<LoxList>(std::move(elements));
 }
 
 void lox::Interpreter::visitLiteralExpr(const LiteralExpression &expr)
@@ -274,6 +465,35 @@ void lox::Interpreter::visitLogicalExpr(const LogicalExpression &expr)
     _resultingLiteral = getLiteral(expr._right);
 }
 
+void lox::Interpreter::visitSetExpr(const SetExpression &expr)
+{
+    const LoxInstance::instance_ptr instance =
+        checkInstance(expr._name, getLiteral(expr._object), "Only instances have fields.");
+
+    literal_t value = getLiteral(expr._value);
+    instance->set(expr._name, value, expr._cache);
+
+    _resultingLiteral = std::move(value);
+}
+
+void lox::Interpreter::visitSuperExpr(const SuperExpression &expr)
+{
+    const literal_t superclass = _environment->get(expr._keyword);
+    const literal_t object = _environment->get(keywordToken(TokenType::THIS, "this", expr._keyword.line));
+
+    const auto klass = std::static_pointer_cast<LoxClass>(std::get<LoxCallable::callable_ptr>(superclass));
+    const LoxFunction *method = klass->findMethod(expr._method.lexeme);
+    if (!method)
+        throw LoxRuntimeError("Undefined property '" + expr._method.lexeme + "'.", expr._method);
+
+    _resultingLiteral = method->bind(std::get<LoxInstance::instance_ptr>(object));
+}
+
+void lox::Interpreter::visitThisExpr(const ThisExpression &expr)
+{
+    _resultingLiteral = _environment->get(expr._keyword);
+}
+
 void lox::Interpreter::visitUnaryExpr(const UnaryExpression &expr)
 {
     literal_t right = getLiteral(expr._right);
@@ -285,8 +505,9 @@ void lox::Interpreter::visitUnaryExpr(const UnaryExpression &expr)
         _resultingLiteral = !isTruthy(right);
         break;
     case MINUS:
-        checkOperand(expr._operator, right);
-        _resultingLiteral = -std::get<double>(right);
+        if (!expr._unchecked || !isNumber(right)) // see evaluateBinary
+            checkOperand(expr._operator, right);
+        _resultingLiteral = numbers::negate(right);
         break;
     default:
         _resultingLiteral = nullptr;
@@ -295,7 +516,40 @@ void lox::Interpreter::visitUnaryExpr(const UnaryExpression &expr)
 
 void lox::Interpreter::visitVarExpr(const VarExpression &expr)
 {
-    _resultingLiteral = _environment->get(expr._name);
+    if (expr._isGlobal)
+        _resultingLiteral = _globals->getGlobal(expr._name, expr._cache);
+    else
+        _resultingLiteral = _environment->get(expr._name);
+}
+
+// ----- fused expressions -----
+
+void lox::Interpreter::visitIncrementExpr(const IncrementExpression &expr)
+{
+    literal_t &value = variable(expr._name, expr._isGlobal, expr._cache);
+    value = evaluateBinary(expr._operator, value, expr._delta, expr._unchecked);
+    _resultingLiteral = value;
+}
+
+void lox::Interpreter::visitCompareConstExpr(const CompareConstExpression &expr)
+{
+    const literal_t &value = variable(expr._name, expr._isGlobal, expr._cache);
+    _resultingLiteral = evaluateBinary(expr._operator, value, expr._constant, expr._unchecked);
+}
+
+void lox::Interpreter::visitAssignBinaryExpr(const AssignBinaryExpression &expr)
+{
+    // the right operand can't define variables, so the reference stays valid
+    literal_t &value = variable(expr._name, expr._isGlobal, expr._cache);
+    const literal_t right = getLiteral(expr._right);
+
+    value = evaluateBinary(expr._operator, value, right, expr._unchecked);
+    _resultingLiteral = value;
+}
+
+void lox::Interpreter::visitLiteralCallExpr(const LiteralCallExpression &expr)
+{
+    evaluateCall(*expr._call, &expr._args);
 }
 
 // ---- private area -----
@@ -312,18 +566,9 @@ void lox::Interpreter::executeBlock(const Statement::stmt_vec &stmts, Environmen
         for (const Statement::stmt_ptr &stmt : stmts)
             stmt->accept(*this); // execute
     }
-    catch (std::runtime_error &)
+    catch (...) // runtime errors, return and break
     {
         this->_environment = outer; // exit block, so going back to old environment
-    }
-    catch (Return &)
-    {
-        this->_environment = outer;
-        throw;
-    }
-    catch (Break &)
-    {
-        this->_environment = outer;
         throw;
     }
 
@@ -331,27 +576,286 @@ void lox::Interpreter::executeBlock(const Statement::stmt_vec &stmts, Environmen
     this->_environment = outer;
 }
 
+const lox::Statement::stmt_vec &lox::Interpreter::lazyBody(const FunctionStatement &function)
+{
+    LazyBody &lazy = *function._lazy;
+
+    if (lazy.state == LazyBody::State::UNPARSED)
+    {
+        // errors are reported like the ones found at load time, but only this body decides whether it can run
+        const std::size_t errorCount = _errors.errorCount();
+
+        Parser parser{lazy.tokens, _errors}; // takes the tokens, they aren't needed anymore
+        Statement::stmt_vec body = parser.parse();
+
+        // the static passes see the body as the one of a top level function, which it is
+        std::vector<Token> params = function._params;
+        const std::shared_ptr<FunctionStatement> declaration =
+            std::make_shared<FunctionStatement>(function._name, params, body);
+        const Statement::stmt_vec program{declaration};
+
+        if (_errors.errorCount() == errorCount)
+        {
+            Resolver resolver{_errors};
+            resolver.resolve(program);
+        }
+
+        if (_errors.errorCount() == errorCount)
+        {
+            TypeInference inference;
+            inference.infer(program);
+
+            Fuser fuser;
+            fuser.fuse(program);
+
+            lazy.body = declaration->_body;
+            lazy.state = LazyBody::State::PARSED;
+        }
+        else
+            lazy.state = LazyBody::State::FAILED;
+    }
+
+    if (lazy.state == LazyBody::State::FAILED)
+        throw LoxRuntimeError{"Can't call '" + function._name.lexeme + "', its body has errors.", function._name};
+
+    return lazy.body;
+}
+
 lox::literal_t lox::Interpreter::getLiteral(const Expression::expr_ptr &expr)
 {
     expr->accept(*this);
     return std::move(_resultingLiteral);
 }
 
-void lox::Interpreter::evaluatePlus(const literal_t &left, const literal_t &right, const Token &op)
+lox::literal_t &lox::Interpreter::variable(const Token &name, bool isGlobal, GlobalCache &cache)
 {
-    using namespace std;
+    return isGlobal ? _globals->lookupGlobal(name, cache) : _environment->lookup(name);
+}
+
+lox::literal_t lox::Interpreter::evaluateBinary(const Token &op, const literal_t &left, const literal_t &right,
+                                                bool unchecked)
+{
+    using enum TokenType;
 
-    if (holds_alternative<double>(left) && holds_alternative<double>(right))
+    try
     {
-        _resultingLiteral = get<double>(left) + get<double>(right);
-        return;
+        switch (op.type)
+        {
+        case GREATER:
+            if (!unchecked)
+                checkOperand(op, left, right);
+            return numbers::less(right, left);
+        case GREATER_EQUAL:
+            if (!unchecked)
+                checkOperand(op, left, right);
+            return numbers::lessEqual(right, left);
+        case LESS:
+            if (!unchecked)
+                checkOperand(op, left, right);
+            return numbers::less(left, right);
+        case LESS_EQUAL:
+            if (!unchecked)
+                checkOperand(op, left, right);
+            return numbers::lessEqual(left, right);
+        case EQUAL_EQUAL:
+            return isEqual(left, right);
+        case BANG_EQUAL:
+            return !isEqual(left, right);
+        case MINUS:
+            if (!unchecked)
+                checkOperand(op, left, right);
+            return numbers::subtract(left, right);
+        case PLUS:
+            if (unchecked)
+                return numbers::add(left, right);
+            return evaluatePlus(left, right, op);
+        case SLASH:
+            if (!unchecked)
+                checkOperand(op, left, right);
+
+            if (toDouble(right) == 0)
+                throw LoxRuntimeError("Can't divide by 0.", op);
+
+            return numbers::divide(left, right);
+        case STAR:
+            if (!unchecked)
+                checkOperand(op, left, right);
+            return numbers::multiply(left, right);
+        default:
+            return nullptr;
+        }
+    }
+    catch (const std::bad_variant_access &)
+    {
+        // only unchecked operands get here: the type inference proved them numbers, but something it can't see
+        // changed one of them after all. the checked path reports the error
+        return evaluateBinary(op, left, right, false);
     }
+}
 
-    if (holds_alternative<string>(left) || holds_alternative<string>(right))
+// the body sees (and may change) the counter in the environment, it's only kept native in between.
+// as soon as the counter or the bound isn't an int, an iteration takes the generic path (condition, increment)
+void lox::Interpreter::runCountedLoop(const ForStatement &stmt)
+{
+    const Token &name = stmt._initializer->_name;
+    const LiteralExpression *constantBound = dynamic_cast<const LiteralExpression *>(stmt._bound.get());
+
+    for (;;)
     {
-        _resultingLiteral = toString(left) + toString(right);
-        return;
+        const literal_t &counter = _environment->lookup(name);
+        bool proceed;
+
+        if (std::holds_alternative<std::int64_t>(counter))
+        {
+            const std::int64_t i = std::get<std::int64_t>(counter);
+            const literal_t bound = constantBound ? constantBound->_value : getLiteral(stmt._bound);
+
+            if (std::holds_alternative<std::int64_t>(bound))
+            {
+                const std::int64_t b = std::get<std::int64_t>(bound);
+                switch (stmt._comparison.type)
+                {
+                case TokenType::LESS:
+                    proceed = i < b;
+                    break;
+                case TokenType::LESS_EQUAL:
+                    proceed = i <= b;
+                    break;
+                case TokenType::GREATER:
+                    proceed = i > b;
+                    break;
+                default:
+                    proceed = i >= b;
+                }
+            }
+            else // the bound was evaluated already, so don't evaluate the whole condition again
+                proceed = isTruthy(evaluateBinary(stmt._comparison, i, bound, false));
+        }
+        else
+            proceed = isTruthy(getLiteral(stmt._condition));
+
+        if (!proceed)
+            return;
+
+        stmt._body->accept(*this);
+
+        literal_t &next = _environment->lookup(name);
+        std::int64_t incremented;
+        if (std::holds_alternative<std::int64_t>(next) &&
+            numbers::addInts(std::get<std::int64_t>(next), stmt._step, incremented))
+            next = incremented;
+        else
+            getLiteral(stmt._increment);
+    }
+}
+
+// the range is evaluated once up front, the chunks run on copies (see runChunks) and only the reduction comes back
+void lox::Interpreter::runParallelLoop(const ForStatement &stmt)
+{
+    const Reduction &reduction = *stmt._reduction;
+
+    const literal_t start = stmt._initializer->_initializer ? getLiteral(stmt._initializer->_initializer) : nullptr;
+    const literal_t bound = getLiteral(stmt._bound);
+    if (!numbers::bothInts(start, bound))
+        throw LoxRuntimeError{"The range of a parallel loop must be integers.", stmt._initializer->_name};
+
+    // start, start + step, ... as long as the condition holds. unsigned, the distance may not fit into an int64
+    const std::int64_t first = std::get<std::int64_t>(start);
+    const std::int64_t last = std::get<std::int64_t>(bound);
+    const std::uint64_t step = static_cast<std::uint64_t>(stmt._step);
+    const bool inclusive = stmt._comparison.type == TokenType::LESS_EQUAL;
+
+    std::uint64_t iterations = 0;
+    if (last > first || (inclusive && last == first))
+    {
+        const std::uint64_t distance = static_cast<std::uint64_t>(last) - static_cast<std::uint64_t>(first);
+        iterations = (inclusive ? distance : distance - 1) / step + 1;
+    }
+
+    const literal_t acc = variable(reduction.accumulator, reduction.isGlobal, reduction.cache);
+    if (!isNumber(acc))
+        throw LoxRuntimeError{"The accumulator of a parallel loop must be a number.", reduction.accumulator};
+
+    // of the same type as acc, the static passes saw acc going into the body
+    const bool sum = reduction.op.type == TokenType::PLUS;
+    const literal_t identity = std::holds_alternative<std::int64_t>(acc) ? literal_t{std::int64_t{sum ? 0 : 1}}
+                                                                         : literal_t{sum ? 0.0 : 1.0};
+
+    literal_t result = acc;
+    for (const literal_t &partial : runChunks(*this, stmt, _environment, first, iterations, identity))
+        result = evaluateBinary(reduction.op, result, partial, false);
+
+    variable(reduction.accumulator, reduction.isGlobal, reduction.cache) = result;
+}
+
+// literalArgs are the pre-evaluated arguments of a LiteralCallExpression
+void lox::Interpreter::evaluateCall(const CallExpression &expr, const std::vector<literal_t> *literalArgs)
+{
+    std::vector<literal_t> evaluated;
+    const auto arguments = [&]() -> const std::vector<literal_t> & {
+        if (literalArgs)
+            return *literalArgs;
+
+        evaluated = evaluateArguments(expr);
+        return evaluated;
+    };
+
+    literal_t callee;
+
+    if (expr._method) // object.method(...) -> call methods directly, without binding them first
+    {
+        const LoxInstance::instance_ptr instance =
+            checkInstance(expr._method->_name, getLiteral(expr._method->_object), "Only instances have properties.");
+
+        const PropertyCache::Entry *property = instance->lookup(expr._method->_name, expr._method->_cache);
+        if (!property)
+            throw LoxRuntimeError("Undefined property '" + expr._method->_name.lexeme + "'.", expr._method->_name);
+
+        if (property->method)
+        {
+            const std::vector<literal_t> &args = arguments();
+            checkArity(*property->method, args, expr._paren);
+
+            _resultingLiteral = property->method->callMethod(*this, args, instance, expr._paren);
+            return;
+        }
+
+        callee = instance->field(property->slot); // a field holding a function
     }
+    else
+        callee = getLiteral(expr._callee);
+
+    const std::vector<literal_t> &args = arguments();
+
+    if (!std::holds_alternative<LoxCallable::callable_ptr>(callee))
+        throw LoxRuntimeError("Can only call functions and classes.", expr._paren);
+
+    LoxCallable::callable_ptr function = std::get<LoxCallable::callable_ptr>(callee);
+    checkArity(*function, args, expr._paren);
+
+    _resultingLiteral = function->call(*this, args, expr._paren);
+}
+
+std::vector<lox::literal_t> lox::Interpreter::evaluateArguments(const CallExpression &expr)
+{
+    std::vector<literal_t> arguments;
+    arguments.reserve(expr._args.size());
+
+    for (const Expression::expr_ptr &arg : expr._args)
+        arguments.push_back(getLiteral(arg));
+
+    return arguments;
+}
+
+lox::literal_t lox::Interpreter::evaluatePlus(const literal_t &left, const literal_t &right, const Token &op)
+{
+    using namespace std;
+
+    if (isNumber(left) && isNumber(right))
+        return numbers::add(left, right);
+
+    if (holds_alternative<string>(left) || holds_alternative<string>(right))
+        return toString(left) + toString(right);
 
     throw LoxRuntimeError("Operands must be two numbers or strings.", op);
 }
@@ -370,6 +874,10 @@ bool lox::Interpreter::isTruthy(const literal_t &lit)
 
 bool lox::Interpreter::isEqual(const literal_t &a, const literal_t &b)
 {
+    // ints and doubles are both just numbers
+    if (isNumber(a) && isNumber(b))
+        return numbers::equal(a, b);
+
     // not the same type
     if (a.index() != b.index())
         return false;
@@ -378,19 +886,26 @@ bool lox::Interpreter::isEqual(const literal_t &a, const literal_t &b)
 
     if (holds_alternative<nullptr_t>(a))
         return true;
-    if (holds_alternative<double>(a))
-        return get<double>(a) == get<double>(b);
     if (holds_alternative<bool>(a))
         return get<bool>(a) == get<bool>(b);
     if (holds_alternative<string>(a))
         return get<string>(a) == get<string>(b);
+
+    // callables, lists, maps and instances are compared by identity
+    if (holds_alternative<LoxCallable::callable_ptr>(a))
+        return get<LoxCallable::callable_ptr>(a) == get<LoxCallable::callable_ptr>(b);
+    if (holds_alternative<LoxList::list_ptr>(a))
+        return get<LoxList::list_ptr>(a) == get<LoxList::list_ptr>(b);
+    if (holds_alternative<LoxInstance::instance_ptr>(a))
+        return get<LoxInstance::instance_ptr>(a) == get<LoxInstance::instance_ptr>(b);
+    return get<LoxMap::map_ptr>(a) == get<LoxMap::map_ptr>(b);
 }
 
 // ----- error handling / type checking -----
 
 void lox::Interpreter::checkOperand(const Token &op, const literal_t &operand)
 {
-    if (std::holds_alternative<double>(operand))
+    if (isNumber(operand))
         return;
 
     throw LoxRuntimeError("Operand must be a number.", op);
@@ -398,8 +913,56 @@ void lox::Interpreter::checkOperand(const Token &op, const literal_t &operand)
 
 void lox::Interpreter::checkOperand(const Token &op, const literal_t &left, const literal_t &right)
 {
-    if (std::holds_alternative<double>(left) && std::holds_alternative<double>(right))
+    if (isNumber(left) && isNumber(right))
         return;
 
     throw LoxRuntimeError("Operands must be numbers.", op);
 }
+
+std::size_t lox::Interpreter::checkIndex(const Token &bracket, const LoxList &list, const literal_t &index)
+{
+    if (std::holds_alternative<std::int64_t>(index))
+    {
+        const std::int64_t i = std::get<std::int64_t>(index);
+        if (i < 0 || static_cast<std::size_t>(i) >= list.size())
+            throw LoxRuntimeError("Index out of range.", bracket);
+
+        return static_cast<std::size_t>(i);
+    }
+
+    if (!std::holds_alternative<double>(index))
+        throw LoxRuntimeError("Index must be a number.", bracket);
+
+    const double i = std::get<double>(index);
+    if (std::floor(i) != i)
+        throw LoxRuntimeError("Index must be an integer.", bracket);
+    if (i < 0 || i >= list.size())
+        throw LoxRuntimeError("Index out of range.", bracket);
+
+    return static_cast<std::size_t>(i);
+}
+
+void lox::Interpreter::checkKey(const Token &bracket, const literal_t &key)
+{
+    if (!LoxMap::isValidKey(key))
+        throw LoxRuntimeError("Map keys must be strings, numbers or bools.", bracket);
+}
+
+void lox::Interpreter::checkArity(const LoxCallable &callee, const std::vector<literal_t> &args, const Token &paren)
+{
+    if (static_cast<int>(args.size()) == callee.arity() || callee.arity() == LoxCallable::variadic)
+        return;
+
+    const std::string msg =
+        "Expected " + std::to_string(callee.arity()) + " arguments but got " + std::to_string(args.size()) + ".";
+    throw LoxRuntimeError(msg, paren);
+}
+
+lox::LoxInstance::instance_ptr lox::Interpreter::checkInstance(const Token &name, const literal_t &object,
+                                                               const char *message)
+{
+    if (!std::holds_alternative<LoxInstance::instance_ptr>(object))
+        throw LoxRuntimeError(message, name);
+
+    return std::get<LoxInstance::instance_ptr>(object);
+}
@@ -0,0 +1,166 @@
+#include "../include/evaluating/LineProfile.h"
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+using namespace lox;
+
+int either(int line, int fallback)
+{
+    return line != 0 ? line : fallback;
+}
+
+// the line an expression starts on, 0 if it has no token (literals)
+int lineOf(const Expression *expr)
+{
+    if (!expr)
+        return 0;
+
+    if (const AssignExpression *assign = dynamic_cast<const AssignExpression *>(expr))
+        return assign->_name.line;
+    if (const VarExpression *var = dynamic_cast<const VarExpression *>(expr))
+        return var->_name.line;
+    if (const BinaryExpression *binary = dynamic_cast<const BinaryExpression *>(expr))
+        return either(lineOf(binary->_left.get()), binary->_operator.line);
+    if (const LogicalExpression *logical = dynamic_cast<const LogicalExpression *>(expr))
+        return either(lineOf(logical->_left.get()), logical->_operator.line);
+    if (const CallExpression *call = dynamic_cast<const CallExpression *>(expr))
+        return either(lineOf(call->_callee.get()), call->_paren.line);
+    if (const GetExpression *get = dynamic_cast<const GetExpression *>(expr))
+        return either(lineOf(get->_object.get()), get->_name.line);
+    if (const SetExpression *set = dynamic_cast<const SetExpression *>(expr))
+        return either(lineOf(set->_object.get()), set->_name.line);
+    if (const IndexExpression *index = dynamic_cast<const IndexExpression *>(expr))
+        return either(lineOf(index->_object.get()), index->_bracket.line);
+    if (const IndexAssignExpression *index = dynamic_cast<const IndexAssignExpression *>(expr))
+        return either(lineOf(index->_object.get()), index->_bracket.line);
+    if (const GroupingExpression *grouping = dynamic_cast<const GroupingExpression *>(expr))
+        return lineOf(grouping->_expression.get());
+    if (const UnaryExpression *unary = dynamic_cast<const UnaryExpression *>(expr))
+        return unary->_operator.line;
+    if (const ThisExpression *self = dynamic_cast<const ThisExpression *>(expr))
+        return self->_keyword.line;
+    if (const SuperExpression *super = dynamic_cast<const SuperExpression *>(expr))
+        return super->_keyword.line;
+    if (const ListExpression *list = dynamic_cast<const ListExpression *>(expr))
+        return list->_elements.empty() ? 0 : lineOf(list->_elements.front().get());
+
+    // fused by the Fuser
+    if (const IncrementExpression *increment = dynamic_cast<const IncrementExpression *>(expr))
+        return increment->_name.line;
+    if (const CompareConstExpression *compare = dynamic_cast<const CompareConstExpression *>(expr))
+        return compare->_name.line;
+    if (const AssignBinaryExpression *assign = dynamic_cast<const AssignBinaryExpression *>(expr))
+        return assign->_name.line;
+    if (const LiteralCallExpression *call = dynamic_cast<const LiteralCallExpression *>(expr))
+        return lineOf(call->_call.get());
+
+    return 0;
+}
+
+int lineOf(const Statement &stmt)
+{
+    if (const ExpressionStatement *expression = dynamic_cast<const ExpressionStatement *>(&stmt))
+        return lineOf(expression->_expr.get());
+    if (const PrintStatement *print = dynamic_cast<const PrintStatement *>(&stmt))
+        return lineOf(print->_expr.get());
+    if (const VarStatement *var = dynamic_cast<const VarStatement *>(&stmt))
+        return var->_name.line;
+    if (const IfStatement *branch = dynamic_cast<const IfStatement *>(&stmt))
+        return lineOf(branch->_condition.get());
+    if (const WhileStatement *loop = dynamic_cast<const WhileStatement *>(&stmt))
+        return lineOf(loop->_condition.get());
+    if (const ForStatement *loop = dynamic_cast<const ForStatement *>(&stmt))
+        return loop->_initializer->_name.line;
+    if (const ReturnStatement *ret = dynamic_cast<const ReturnStatement *>(&stmt))
+        return ret->_keyword.line;
+    if (const BreakStatement *brk = dynamic_cast<const BreakStatement *>(&stmt))
+        return brk->_keyword.line;
+    if (const FunctionStatement *function = dynamic_cast<const FunctionStatement *>(&stmt))
+        return function->_name.line;
+    if (const ClassStatement *klass = dynamic_cast<const ClassStatement *>(&stmt))
+        return klass->_name.line;
+
+    return 0;
+}
+
+double milliseconds(LineProfile::clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+} // namespace
+
+void lox::LineProfile::report(std::ostream &out, const std::string &source, std::size_t top) const
+{
+    // statements of the same line come together
+    std::map<int, Entry> lines;
+    clock::duration total{0};
+    for (const auto &[stmt, entry] : _entries)
+    {
+        Entry &line = lines[entry.line];
+        line.line = entry.line;
+        line.hits += entry.hits;
+        line.time += entry.time;
+        total += entry.time;
+    }
+
+    const auto share = [&](const Entry &line) {
+        return total.count() > 0 ? 100.0 * static_cast<double>(line.time.count()) / static_cast<double>(total.count())
+                                 : 0.0;
+    };
+
+    const std::ios::fmtflags flags = out.flags();
+    out << std::fixed << "line profile: " << std::setprecision(3) << milliseconds(total) << " ms\n"
+        << "  line        hits     time ms       %  source\n";
+
+    std::istringstream lineStream{source};
+    std::string text;
+    for (int number = 1; std::getline(lineStream, text); ++number)
+    {
+        out << std::setw(6) << number;
+        if (const auto line = lines.find(number); line != lines.end())
+        {
+            out << std::setw(12) << line->second.hits << std::setw(12) << std::setprecision(3)
+                << milliseconds(line->second.time) << std::setw(8) << std::setprecision(1) << share(line->second);
+        }
+        else
+            out << std::string(32, ' ');
+
+        out << "  " << text << "\n";
+    }
+
+    std::vector<Entry> ranked;
+    for (const auto &[number, line] : lines)
+        ranked.push_back(line);
+    std::sort(ranked.begin(), ranked.end(), [](const Entry &a, const Entry &b) { return a.time > b.time; });
+    ranked.resize(std::min(ranked.size(), top));
+
+    out << "top " << ranked.size() << " lines by time:\n";
+    for (const Entry &line : ranked)
+    {
+        out << std::setw(6) << line.line << std::setw(12) << line.hits << std::setw(12) << std::setprecision(3)
+            << milliseconds(line.time) << std::setw(8) << std::setprecision(1) << share(line) << "\n";
+    }
+
+    out.flags(flags);
+}
+
+// ---- private area -----
+
+lox::LineProfile::Entry &lox::LineProfile::entry(const Statement &stmt)
+{
+    const auto [found, added] = _entries.try_emplace(&stmt);
+    if (added)
+    {
+        // a statement without a token of its own (print 1;) counts for the statement around it
+        found->second.line = lineOf(stmt);
+        if (found->second.line == 0 && _current)
+            found->second.line = _current->_entry->line;
+    }
+
+    return found->second;
+}
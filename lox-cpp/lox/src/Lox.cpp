@@ -1,19 +1,104 @@
 #include "../include/Lox.h"
+#include "../include/evaluating/Fuser.h"
+#include "../include/evaluating/Inliner.h"
 #include "../include/evaluating/Interpreter.h"
+#include "../include/evaluating/Resolver.h"
+#include "../include/evaluating/TypeInference.h"
+#include "../include/parsing/AstCache.h"
 #include "../include/parsing/Parser.h"
 #include "../include/scanning/Scanner.h"
+#include "../include/types/LoxClass.h"
+#include "../include/types/LoxList.h"
+#include "../include/types/LoxMap.h"
 
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <string>
+#include <unordered_map>
 
-lox::Interpreter lox::Lox::_interpreter;
+namespace
+{
+double milliseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+using copies_t = std::unordered_map<const void *, lox::literal_t>; // already copied values, for cycles
+
+bool isMutable(const lox::literal_t &value)
+{
+    using namespace lox;
+
+    return std::holds_alternative<LoxList::list_ptr>(value) || std::holds_alternative<LoxMap::map_ptr>(value) ||
+           std::holds_alternative<LoxInstance::instance_ptr>(value);
+}
+
+// lists, maps and instances are copied deeply, the rest is immutable or shared (functions, classes)
+lox::literal_t deepCopy(const lox::literal_t &value, copies_t &copies)
+{
+    using namespace lox;
+
+    if (const LoxList::list_ptr *list = std::get_if<LoxList::list_ptr>(&value))
+    {
+        if (const auto copied = copies.find(list->get()); copied != copies.end())
+            return copied->second;
+
+        const LoxList::list_ptr target = std::make_shared<LoxList>(**list);
+        copies[list->get()] = target;
+        if (!target->isNumeric())
+        {
+            for (std::size_t i = 0; i < target->size(); ++i)
+                target->set(i, deepCopy(target->get(i), copies));
+        }
+        return target;
+    }
+
+    if (const LoxMap::map_ptr *map = std::get_if<LoxMap::map_ptr>(&value))
+    {
+        if (const auto copied = copies.find(map->get()); copied != copies.end())
+            return copied->second;
+
+        const LoxMap::map_ptr target = std::make_shared<LoxMap>(**map);
+        copies[map->get()] = target;
+        (*map)->forEach(
+            [&](const literal_t &key, const literal_t &entry) { target->set(key, deepCopy(entry, copies)); });
+        return target;
+    }
+
+    if (const LoxInstance::instance_ptr *instance = std::get_if<LoxInstance::instance_ptr>(&value))
+    {
+        if (const auto copied = copies.find(instance->get()); copied != copies.end())
+            return copied->second;
 
-// init hadError variables
-bool lox::Lox::hadError = false;
-bool lox::Lox::hadRuntimeError = false;
+        const LoxInstance::instance_ptr target = (*instance)->clone();
+        copies[instance->get()] = target;
+        for (std::uint32_t slot = 0; slot < target->fieldCount(); ++slot)
+            target->setField(slot, deepCopy(target->field(slot), copies));
+        return target;
+    }
+
+    return value;
+}
+} // namespace
+
+lox::Lox::Lox() : Lox{Options{}}
+{
+}
+
+lox::Lox::Lox(const Options &options) : Lox{options, std::cout, std::cerr}
+{
+}
+
+lox::Lox::Lox(const Options &options, std::ostream &out, std::ostream &err)
+    : _options{options}, _out{out}, _err{err}, _errors{err}, _interpreter{std::make_unique<Interpreter>(out, _errors)}
+{
+}
+
+lox::Lox::~Lox() = default; // Interpreter is incomplete in the header
 
 // run .lox file
-void lox::Lox::runFile(const std::string &&filename)
+bool lox::Lox::runFile(const std::string &&filename)
 {
     // ---- read in file to sourceCode string ----
     std::ifstream fileStream(filename);
@@ -29,40 +114,216 @@ void lox::Lox::runFile(const std::string &&filename)
     }
     else
     {
-        std::cerr << "Failed to open file!" << std::endl;
-        fileStream.close();
-        std::exit(EXIT_FAILURE);
+        _err << "Failed to open file!" << std::endl;
+        return false;
+    }
+
+#ifdef LOX_LINE_PROFILE
+    if (_options.lineProfile)
+    {
+        // the statements are looked up while the isolate is alive, the report comes right after the run
+        LineProfile profile;
+        _interpreter->profileLines(&profile);
+        run(sourceCode, filename);
+        _interpreter->profileLines(nullptr);
+        profile.report(_err, sourceCode);
+
+        return !hadError() && !hadRuntimeError();
     }
+#else
+    if (_options.lineProfile)
+        _err << "No line profile, lox-cpp has to be built with LOX_LINE_PROFILE defined." << std::endl;
+#endif
 
-    run(sourceCode);
+    run(sourceCode, filename);
 
-    // indicate error with exit code
-    if (hadError || hadRuntimeError)
-        std::exit(EXIT_FAILURE);
+    return !hadError() && !hadRuntimeError();
 }
 
 // execute lox commands in the cmd
 void lox::Lox::runPrompt()
 {
+    _prompt = true;
+
     std::string enteredSource;
-    while (std::cout << "> " && std::getline(std::cin, enteredSource))
+    while (_out << "> " && std::getline(std::cin, enteredSource))
     {
         run(enteredSource);
-        hadError = false;
+        _errors.reset();
     }
 }
 
 void lox::Lox::run(const std::string &sourceCode)
 {
-    Scanner scanner{sourceCode};
+    run(sourceCode, {});
+}
+
+std::shared_ptr<const lox::Program> lox::Lox::prepare(const std::string &sourceCode)
+{
+    // a program can run on isolates that ran other code before
+    const Statement::stmt_vec statements = compile(sourceCode, true);
+    if (_errors.hadError())
+        return nullptr;
+
+    const std::uint64_t hash = AstCache::hash(sourceCode);
+    std::optional<std::string> image = AstCache::serialize(hash, _options.lazy, statements);
+    if (!image)
+        return nullptr; // only runtime values can't be written, the passes never put them into the AST
+
+    return std::make_shared<const Program>(std::move(*image), hash, _options.lazy);
+}
+
+bool lox::Lox::execute(const std::shared_ptr<const Program> &program)
+{
+    auto instance = std::find_if(_instances.begin(), _instances.end(),
+                                 [&](const auto &entry) { return entry.first == program; });
+    if (instance == _instances.end())
+    {
+        _instances.emplace_back(program, program->instantiate());
+        instance = _instances.end() - 1;
+    }
+
+    _errors.reset();
+    _ranCode = true;
+    _interpreter->interpret(instance->second->statements(), program);
+    return !_errors.hadRuntimeError();
+}
+
+void lox::Lox::define(const std::string &name, const literal_t &value)
+{
+    _interpreter->globals()->define(name, value);
+}
+
+std::optional<lox::literal_t> lox::Lox::global(const std::string &name) const
+{
+    if (const literal_t *value = _interpreter->globals()->value(name))
+        return *value;
+
+    return std::nullopt;
+}
+
+void lox::Lox::snapshotGlobals()
+{
+    // the functions defined so far keep the snapshot as their closure, the scripts get copies
+    _snapshot = _interpreter->globals();
+    _interpreter->resetGlobals(*_snapshot);
+}
+
+void lox::Lox::restoreGlobals()
+{
+    _interpreter->resetGlobals(*_snapshot);
+
+    // the lists, maps and instances of the snapshot are copied too, or a script's changes to them would stay
+    copies_t copies;
+    _snapshot->forEach([&](const std::string &name, const literal_t &value) {
+        if (isMutable(value))
+            _interpreter->globals()->define(name, deepCopy(value, copies));
+    });
+}
+
+// ---- private area -----
+
+void lox::Lox::run(const std::string &sourceCode, const std::string &script)
+{
+    using clock = std::chrono::steady_clock;
+
+    // the cached ASTs are compiled for a global scope of their own
+    const bool shared = sharedGlobals();
+    _ranCode = true;
+
+    if (!_options.cache || script.empty() || shared)
+    {
+        Statement::stmt_vec statements = compile(sourceCode, shared);
+        if (!_errors.hadError())
+            _interpreter->interpret(statements);
+        return;
+    }
+
+    const std::uint64_t hash = AstCache::hash(sourceCode);
+    const std::string cachePath = AstCache::path(script, _options.cacheDir, hash);
+
+    const clock::time_point start = clock::now();
+    std::optional<Statement::stmt_vec> statements = AstCache::load(cachePath, hash, _options.lazy);
+    const clock::time_point loaded = clock::now();
+
+    if (statements)
+    {
+        if (_options.report)
+            _err << "ast cache: hit " << cachePath << ", loaded in " << milliseconds(loaded - start) << " ms\n";
+    }
+    else
+    {
+        statements = compile(sourceCode, false);
+        if (_errors.hadError())
+            return;
+
+        const clock::time_point compiled = clock::now();
+        const bool stored = AstCache::store(cachePath, hash, _options.lazy, *statements);
+
+        if (_options.report)
+            _err << "ast cache: miss " << cachePath << ", compiled in " << milliseconds(compiled - start) << " ms, "
+                 << (stored ? "stored in " : "failed to store in ") << milliseconds(clock::now() - compiled) << " ms\n";
+    }
+
+    _interpreter->interpret(*statements);
+}
+
+lox::Statement::stmt_vec lox::Lox::compile(const std::string &sourceCode, bool shared)
+{
+    Scanner scanner{sourceCode, _errors};
     Scanner::tokenlist_t tokens = scanner.scanTokens();
 
-    Parser parser{tokens};
+    Parser parser{tokens, _errors, _options.lazy};
     Statement::stmt_vec statements = parser.parse();
 
-    if (hadError)
-        return;
+    if (_options.report && _options.lazy)
+        _err << "lazy parsing: skipped " << parser.lazyBodies() << " function bodies (" << parser.lazyTokens()
+             << " tokens)\n";
+
+    if (_errors.hadError())
+        return {};
+
+    Resolver resolver{_errors};
+    resolver.resolve(statements);
+
+    if (_errors.hadError())
+        return {};
+
+    // the prompt runs the program in pieces, a later line could redefine an inlined function
+    if (!_prompt)
+    {
+        Inliner inliner;
+        inliner.inlineCalls(statements);
+
+        if (_options.report)
+        {
+            _err << "inlining: " << inliner.inlinedCalls() << " call sites";
+            for (const auto &[name, calls] : inliner.inlinedCallsPerFunction())
+                _err << ", " << name << " " << calls;
+            _err << "\n";
+        }
+    }
+
+    TypeInference inference{!shared};
+    inference.infer(statements);
+
+    if (_options.report)
+        _err << "type inference: removed " << inference.removedChecks() << " of " << inference.totalChecks()
+             << " dynamic type checks\n";
+
+    Fuser fuser;
+    fuser.fuse(statements);
+
+    if (_options.report)
+    {
+        _err << "fusion:";
+        for (std::size_t i = 0; i < static_cast<std::size_t>(Fuser::Pattern::COUNT); ++i)
+        {
+            const Fuser::Pattern pattern = static_cast<Fuser::Pattern>(i);
+            _err << (i ? ", " : " ") << Fuser::name(pattern) << " " << fuser.hits(pattern);
+        }
+        _err << "\n";
+    }
 
-    // evaluate statements
-    _interpreter.interpret(statements);
+    return statements;
 }
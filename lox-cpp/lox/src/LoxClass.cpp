@@ -0,0 +1,82 @@
+#include "../include/types/LoxClass.h"
+#include "../include/types/Throwables.h"
+
+const lox::LoxFunction *lox::LoxClass::findMethod(const std::string &name) const
+{
+    const auto method = _methods.find(name);
+    if (method != _methods.end())
+        return method->second.get();
+
+    if (_superclass)
+        return _superclass->findMethod(name);
+
+    return nullptr;
+}
+
+lox::literal_t lox::LoxClass::call(Interpreter &interpreter, const std::vector<literal_t> &args,
+                                  const Token &paren) const
+{
+    // const_pointer_cast: the instance only reads the class
+    auto instance = std::make_shared<LoxInstance>(std::const_pointer_cast<LoxClass>(shared_from_this()));
+
+    if (const LoxFunction *initializer = findMethod("init"))
+        initializer->callMethod(interpreter, args, instance, paren);
+
+    return instance;
+}
+
+// ---- instances ----
+
+const lox::PropertyCache::Entry *lox::LoxInstance::lookup(const Token &name, PropertyCache &cache) const
+{
+    const std::uint32_t shapeId = _shape->id();
+    if (const PropertyCache::Entry *entry = cache.find(shapeId))
+        return entry;
+
+    // cache miss, fields shadow methods
+    const std::uint32_t slot = _shape->slotOf(name);
+    if (slot != HashIndex::npos)
+        return &cache.add(PropertyCache::Entry{shapeId, slot});
+
+    // the shape implies the class, so the method can be cached as well
+    if (const LoxFunction *method = _class->findMethod(name.lexeme))
+        return &cache.add(PropertyCache::Entry{shapeId, 0, method});
+
+    return nullptr;
+}
+
+lox::literal_t lox::LoxInstance::get(const Token &name, PropertyCache &cache)
+{
+    const PropertyCache::Entry *property = lookup(name, cache);
+    if (!property)
+        throw LoxRuntimeError{"Undefined property '" + name.lexeme + "'.", name};
+
+    if (property->method)
+        return property->method->bind(shared_from_this());
+
+    return _fields[property->slot];
+}
+
+void lox::LoxInstance::set(const Token &name, const literal_t &value, PropertyCache &cache)
+{
+    const std::uint32_t shapeId = _shape->id();
+    const PropertyCache::Entry *entry = cache.find(shapeId);
+
+    if (!entry)
+    {
+        const std::uint32_t slot = _shape->slotOf(name);
+        if (slot != HashIndex::npos)
+            entry = &cache.add(PropertyCache::Entry{shapeId, slot});
+        else // new field -> next shape
+            entry = &cache.add(PropertyCache::Entry{shapeId, static_cast<std::uint32_t>(_fields.size()), nullptr,
+                                                    _shape->withField(name)});
+    }
+
+    if (entry->transition)
+    {
+        _shape = entry->transition;
+        _fields.push_back(value);
+    }
+    else
+        _fields[entry->slot] = value;
+}
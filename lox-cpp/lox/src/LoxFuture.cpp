@@ -0,0 +1,201 @@
+#include "../include/types/LoxFuture.h"
+#include "../include/ThreadPool.h"
+#include "../include/types/LoxTask.h"
+#include "../include/types/Throwables.h"
+
+#ifdef __linux__
+#include "../include/EventLoop.h"
+#include <cerrno>
+#include <deque>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+using State = lox::LoxFuture::State;
+
+void complete(State &state, lox::literal_t result, std::string error = {})
+{
+    const std::lock_guard lock{state.mutex};
+    state.done = true;
+    state.result = std::move(result);
+    state.error = std::move(error);
+    state.finished.notify_all();
+}
+
+// the parameters are copies, the job outlives the call that started it
+lox::EventLoop::Job readFileJob(std::shared_ptr<State> state, std::string path)
+{
+    lox::EventLoop &loop = lox::ioLoop();
+
+    const int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+    {
+        complete(*state, nullptr, "Could not open file '" + path + "'.");
+        co_return;
+    }
+
+    std::string contents;
+    char buffer[64 * 1024];
+    for (;;)
+    {
+        const ssize_t n = read(fd, buffer, sizeof buffer);
+        if (n > 0)
+        {
+            contents.append(buffer, static_cast<std::size_t>(n));
+            co_await loop.yield(); // a big file doesn't hold up the others
+        }
+        else if (n == 0)
+            break;
+        else if (errno == EAGAIN)
+            co_await loop.readable(fd);
+        else if (errno != EINTR)
+        {
+            close(fd);
+            complete(*state, nullptr, "Could not read file '" + path + "'.");
+            co_return;
+        }
+    }
+
+    close(fd);
+    complete(*state, std::move(contents));
+}
+
+// stdin is shared, one job at a time reads it and hands out the lines in the order they were asked for.
+// only touched on the loop thread
+struct Stdin
+{
+    std::string buffer; // read, but not handed out yet
+    bool end{false};
+    bool reading{false};
+    std::deque<std::shared_ptr<State>> waiting;
+};
+
+Stdin &stdinLines()
+{
+    static Stdin lines;
+    return lines;
+}
+
+lox::EventLoop::Job readLineJob(std::shared_ptr<State> state)
+{
+    lox::EventLoop &loop = lox::ioLoop();
+    Stdin &in = stdinLines();
+
+    in.waiting.push_back(std::move(state));
+    if (in.reading)
+        co_return; // the job that's reading takes care of this one too
+    in.reading = true;
+
+    char buffer[4096];
+    while (!in.waiting.empty())
+    {
+        if (const std::size_t newline = in.buffer.find('\n'); newline != std::string::npos)
+        {
+            complete(*in.waiting.front(), in.buffer.substr(0, newline));
+            in.buffer.erase(0, newline + 1);
+            in.waiting.pop_front();
+            continue;
+        }
+
+        if (in.end)
+        {
+            // the last line may miss its newline, after that there's nothing
+            complete(*in.waiting.front(), in.buffer.empty() ? lox::literal_t{nullptr} : lox::literal_t{in.buffer});
+            in.buffer.clear();
+            in.waiting.pop_front();
+            continue;
+        }
+
+        // stdin stays blocking (input() reads it too), so it's only read once there is something
+        co_await loop.readable(STDIN_FILENO);
+        const ssize_t n = read(STDIN_FILENO, buffer, sizeof buffer);
+        if (n > 0)
+            in.buffer.append(buffer, static_cast<std::size_t>(n));
+        else if (n == 0 || (errno != EINTR && errno != EAGAIN))
+            in.end = true;
+    }
+
+    in.reading = false;
+}
+
+lox::EventLoop::Job sleepJob(std::shared_ptr<State> state, std::int64_t milliseconds)
+{
+    co_await lox::ioLoop().sleep(std::chrono::milliseconds{milliseconds});
+    complete(*state, nullptr);
+}
+} // namespace
+
+lox::EventLoop &lox::ioLoop()
+{
+    // never destroyed, like the task pool
+    static EventLoop *const loop = new EventLoop{};
+    return *loop;
+}
+#endif
+
+lox::literal_t lox::LoxFuture::call(Interpreter &, const std::vector<literal_t> &, const Token &paren) const
+{
+    throw LoxRuntimeError{"Can only call functions and classes.", paren};
+}
+
+bool lox::LoxFuture::ready() const
+{
+    const std::lock_guard lock{_state->mutex};
+    return _state->done;
+}
+
+lox::literal_t lox::LoxFuture::await() const
+{
+    std::unique_lock lock{_state->mutex};
+    taskPool().block([&] { _state->finished.wait(lock, [&] { return _state->done; }); });
+
+    if (!_state->error.empty())
+        throw NativeError{_state->error};
+
+    return _state->result;
+}
+
+// ---- operations ----
+
+#ifndef __linux__
+
+std::shared_ptr<lox::LoxFuture> lox::LoxFuture::readFile(const std::string &)
+{
+    throw NativeError{"readFile needs epoll, it isn't supported on this platform."};
+}
+
+std::shared_ptr<lox::LoxFuture> lox::LoxFuture::readLine()
+{
+    throw NativeError{"readLine needs epoll, it isn't supported on this platform."};
+}
+
+std::shared_ptr<lox::LoxFuture> lox::LoxFuture::sleep(std::int64_t)
+{
+    throw NativeError{"sleep needs epoll, it isn't supported on this platform."};
+}
+
+#else
+
+std::shared_ptr<lox::LoxFuture> lox::LoxFuture::readFile(const std::string &path)
+{
+    const std::shared_ptr<State> state = std::make_shared<State>();
+    ioLoop().start(readFileJob(state, path));
+    return std::make_shared<LoxFuture>(state);
+}
+
+std::shared_ptr<lox::LoxFuture> lox::LoxFuture::readLine()
+{
+    const std::shared_ptr<State> state = std::make_shared<State>();
+    ioLoop().start(readLineJob(state));
+    return std::make_shared<LoxFuture>(state);
+}
+
+std::shared_ptr<lox::LoxFuture> lox::LoxFuture::sleep(std::int64_t milliseconds)
+{
+    const std::shared_ptr<State> state = std::make_shared<State>();
+    ioLoop().start(sleepJob(state, milliseconds));
+    return std::make_shared<LoxFuture>(state);
+}
+
+#endif
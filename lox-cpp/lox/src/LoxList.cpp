@@ -0,0 +1,184 @@
+#include "../include/types/LoxList.h"
+#include "../include/types/Numbers.h"
+#include "../include/types/Throwables.h"
+#include <algorithm>
+
+lox::LoxList::LoxList(std::vector<literal_t> &&values)
+{
+    const bool allNumbers = std::all_of(values.begin(), values.end(), [](const literal_t &v) { return isNumber(v); });
+
+    if (allNumbers)
+    {
+        _numbers.reserve(values.size());
+        for (const literal_t &v : values)
+            _numbers.push_back(toDouble(v));
+    }
+    else
+    {
+        _numeric = false;
+        _values = std::move(values);
+    }
+}
+
+lox::literal_t lox::LoxList::get(std::size_t index) const
+{
+    if (_numeric)
+        return numbers::normalize(_numbers[index]);
+
+    return _values[index];
+}
+
+void lox::LoxList::set(std::size_t index, const literal_t &value)
+{
+    if (_numeric)
+    {
+        if (isNumber(value))
+        {
+            _numbers[index] = toDouble(value);
+            return;
+        }
+
+        box();
+    }
+
+    _values[index] = value;
+}
+
+void lox::LoxList::push(const literal_t &value)
+{
+    if (_numeric)
+    {
+        if (isNumber(value))
+        {
+            _numbers.push_back(toDouble(value));
+            return;
+        }
+
+        box();
+    }
+
+    _values.push_back(value);
+}
+
+// ---- kernels ----
+// the loops work on plain double buffers with independent accumulators, so the compiler can vectorize them
+
+double lox::LoxList::sum()
+{
+    const std::vector<double> &nums = numbers();
+    const std::size_t n = nums.size();
+
+    double acc[4] = {0, 0, 0, 0};
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        acc[0] += nums[i];
+        acc[1] += nums[i + 1];
+        acc[2] += nums[i + 2];
+        acc[3] += nums[i + 3];
+    }
+
+    for (; i < n; ++i)
+        acc[0] += nums[i];
+
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+double lox::LoxList::min()
+{
+    const std::vector<double> &nums = numbers();
+    if (nums.empty())
+        throw NativeError{"Can't get the minimum of an empty list."};
+
+    double result = nums[0];
+    for (const double n : nums)
+        result = n < result ? n : result;
+
+    return result;
+}
+
+double lox::LoxList::max()
+{
+    const std::vector<double> &nums = numbers();
+    if (nums.empty())
+        throw NativeError{"Can't get the maximum of an empty list."};
+
+    double result = nums[0];
+    for (const double n : nums)
+        result = n > result ? n : result;
+
+    return result;
+}
+
+double lox::LoxList::dot(LoxList &other)
+{
+    const std::vector<double> &a = numbers();
+    const std::vector<double> &b = other.numbers();
+    if (a.size() != b.size())
+        throw NativeError{"Lists must have the same length."};
+
+    const std::size_t n = a.size();
+    double acc[4] = {0, 0, 0, 0};
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        acc[0] += a[i] * b[i];
+        acc[1] += a[i + 1] * b[i + 1];
+        acc[2] += a[i + 2] * b[i + 2];
+        acc[3] += a[i + 3] * b[i + 3];
+    }
+
+    for (; i < n; ++i)
+        acc[0] += a[i] * b[i];
+
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+void lox::LoxList::scale(double factor)
+{
+    for (double &n : numbers())
+        n *= factor;
+}
+
+void lox::LoxList::sort()
+{
+    if (_numeric)
+    {
+        std::sort(_numbers.begin(), _numbers.end());
+        return;
+    }
+
+    const bool allStrings = std::all_of(_values.begin(), _values.end(),
+                                        [](const literal_t &v) { return std::holds_alternative<std::string>(v); });
+    if (!allStrings)
+        throw NativeError{"Only lists of numbers or strings can be sorted."};
+
+    std::sort(_values.begin(), _values.end(),
+              [](const literal_t &a, const literal_t &b) { return std::get<std::string>(a) < std::get<std::string>(b); });
+}
+
+// ---- private area -----
+
+void lox::LoxList::box()
+{
+    _values.reserve(_numbers.size() + 1);
+    for (const double n : _numbers)
+        _values.push_back(numbers::normalize(n));
+
+    _numbers.clear();
+    _numbers.shrink_to_fit();
+    _numeric = false;
+}
+
+std::vector<double> &lox::LoxList::numbers()
+{
+    if (_numeric)
+        return _numbers;
+
+    // the non-numbers might have been overwritten in the meantime
+    *this = LoxList{std::move(_values)};
+    if (!_numeric)
+        throw NativeError{"List must only contain numbers."};
+
+    return _numbers;
+}
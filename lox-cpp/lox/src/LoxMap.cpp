@@ -0,0 +1,104 @@
+#include "../include/types/LoxMap.h"
+#include "../include/types/Numbers.h"
+#include <cmath>
+
+bool lox::LoxMap::isValidKey(const literal_t &key)
+{
+    if (std::holds_alternative<double>(key))
+        return !std::isnan(std::get<double>(key)); // NaN never equals itself
+
+    return std::holds_alternative<std::string>(key) || std::holds_alternative<std::int64_t>(key) ||
+           std::holds_alternative<bool>(key);
+}
+
+const lox::literal_t *lox::LoxMap::get(const literal_t &key) const
+{
+    const literal_t normalized = normalizeKey(key);
+    const std::uint32_t slot = find(hashKey(normalized), normalized);
+    return slot == HashIndex::npos ? nullptr : &_entries[slot].value;
+}
+
+void lox::LoxMap::set(const literal_t &key, const literal_t &value)
+{
+    const literal_t normalized = normalizeKey(key);
+    const std::size_t hash = hashKey(normalized);
+    const std::uint32_t slot = find(hash, normalized);
+
+    if (slot != HashIndex::npos)
+    {
+        _entries[slot].value = value;
+        return;
+    }
+
+    _entries.push_back(Entry{hash, normalized, value, true});
+    _index.insert(hash, static_cast<std::uint32_t>(_entries.size() - 1));
+}
+
+bool lox::LoxMap::remove(const literal_t &key)
+{
+    const literal_t normalized = normalizeKey(key);
+    const std::uint32_t slot = find(hashKey(normalized), normalized);
+    if (slot == HashIndex::npos)
+        return false;
+
+    // the index still points to the entry, but lookups skip it
+    Entry &entry = _entries[slot];
+    entry.alive = false;
+    entry.key = nullptr;
+    entry.value = nullptr;
+    ++_removed;
+
+    if (_removed > 16 && _removed * 2 > _entries.size())
+        compact();
+
+    return true;
+}
+
+// ---- private area -----
+
+lox::literal_t lox::LoxMap::normalizeKey(const literal_t &key)
+{
+    if (!std::holds_alternative<double>(key))
+        return key;
+
+    const double number = std::get<double>(key);
+    return number == 0 ? literal_t{std::int64_t{0}} : numbers::normalize(number); // -0 == 0
+}
+
+std::size_t lox::LoxMap::hashKey(const literal_t &key)
+{
+    if (std::holds_alternative<std::string>(key))
+        return std::hash<std::string>{}(std::get<std::string>(key));
+    if (std::holds_alternative<std::int64_t>(key))
+        return std::hash<std::int64_t>{}(std::get<std::int64_t>(key));
+    if (std::holds_alternative<double>(key))
+        return std::hash<double>{}(std::get<double>(key));
+
+    return std::get<bool>(key) ? 0x9e3779b97f4a7c15ull : 0x7f4a7c159e3779b9ull;
+}
+
+std::uint32_t lox::LoxMap::find(std::size_t hash, const literal_t &key) const
+{
+    return _index.find(hash, [&](std::uint32_t slot) {
+        const Entry &entry = _entries[slot];
+        return entry.alive && entry.hash == hash && entry.key == key;
+    });
+}
+
+void lox::LoxMap::compact()
+{
+    std::vector<Entry> entries;
+    entries.reserve(size());
+    for (Entry &entry : _entries)
+    {
+        if (entry.alive)
+            entries.push_back(std::move(entry));
+    }
+
+    _entries = std::move(entries);
+    _removed = 0;
+
+    _index.clear();
+    for (std::uint32_t i = 0; i < _entries.size(); ++i)
+        _index.insert(_entries[i].hash, i);
+}
@@ -0,0 +1,526 @@
+#include "../include/types/LoxTask.h"
+#include "../include/ErrorHandler.h"
+#include "../include/Program.h"
+#include "../include/ThreadPool.h"
+#include "../include/evaluating/Interpreter.h"
+#include "../include/parsing/AstCache.h"
+#include "../include/types/LoxList.h"
+#include "../include/types/LoxMap.h"
+#include "../include/types/Numbers.h"
+#include "../include/types/Throwables.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+using copies_t = std::unordered_map<const void *, lox::literal_t>; // already copied lists and maps, for cycles
+
+std::optional<lox::literal_t> copy(const lox::literal_t &value, copies_t &copies)
+{
+    using namespace lox;
+
+    if (const LoxList::list_ptr *list = std::get_if<LoxList::list_ptr>(&value))
+    {
+        if (const auto copied = copies.find(list->get()); copied != copies.end())
+            return copied->second;
+
+        if ((*list)->isNumeric())
+        {
+            std::vector<double> numbers((*list)->size());
+            for (std::size_t i = 0; i < numbers.size(); ++i)
+                numbers[i] = toDouble((*list)->get(i));
+
+            return copies[list->get()] = std::make_shared<LoxList>(std::move(numbers));
+        }
+
+        const LoxList::list_ptr target = std::make_shared<LoxList>();
+        copies[list->get()] = target;
+        for (std::size_t i = 0; i < (*list)->size(); ++i)
+        {
+            const std::optional<literal_t> element = copy((*list)->get(i), copies);
+            if (!element)
+                return std::nullopt;
+
+            target->push(*element);
+        }
+
+        return target;
+    }
+
+    if (const LoxMap::map_ptr *map = std::get_if<LoxMap::map_ptr>(&value))
+    {
+        if (const auto copied = copies.find(map->get()); copied != copies.end())
+            return copied->second;
+
+        const LoxMap::map_ptr target = std::make_shared<LoxMap>();
+        copies[map->get()] = target;
+
+        bool complete = true;
+        (*map)->forEach([&](const literal_t &key, const literal_t &entry) {
+            std::optional<literal_t> element = complete ? copy(entry, copies) : std::nullopt;
+            if (element)
+                target->set(key, *element);
+            else
+                complete = false;
+        });
+
+        return complete ? std::optional<literal_t>{target} : std::nullopt;
+    }
+
+    if (const LoxCallable::callable_ptr *callable = std::get_if<LoxCallable::callable_ptr>(&value))
+    {
+        if (std::dynamic_pointer_cast<LoxChannel>(*callable))
+            return value; // shared, it's made for it
+
+        return std::nullopt;
+    }
+
+    if (std::holds_alternative<std::shared_ptr<LoxInstance>>(value))
+        return std::nullopt;
+
+    return value; // nil, bools, numbers and strings
+}
+
+// functions get a copy of their declaration (see Interpreter::visitFunctionStatement), it shares the body
+bool declares(const lox::Statement::stmt_ptr &stmt, const lox::FunctionStatement &function)
+{
+    const lox::FunctionStatement *declaration = dynamic_cast<const lox::FunctionStatement *>(stmt.get());
+
+    return declaration && declaration->_name.lexeme == function._name.lexeme &&
+           declaration->_name.line == function._name.line && declaration->_body == function._body &&
+           declaration->_lazy == function._lazy;
+}
+
+// runs on the task pool, in an isolate of its own
+void runTask(lox::LoxTask::State &state, const std::shared_ptr<const lox::Program> &program, std::size_t index,
+             const std::vector<lox::literal_t> &args, const std::vector<std::pair<std::string, lox::literal_t>> &globals,
+             const lox::Token &paren)
+{
+    using namespace lox;
+
+    std::ostringstream out;
+    std::ostringstream err;
+    ErrorHandler errors{err};
+
+    literal_t result;
+    std::string error;
+    {
+        const std::unique_ptr<Program::Instance> instance = program->instantiate(); // outlives the interpreter
+        Interpreter interpreter{out, errors};
+
+        try
+        {
+            for (const auto &[name, value] : globals)
+                interpreter.globals()->define(name, value);
+
+            interpreter.declare(instance->statements(), program);
+
+            const LoxFunction function{
+                std::static_pointer_cast<const FunctionStatement>(instance->statements()[index]),
+                interpreter.globals()};
+
+            if (std::optional<literal_t> value = transfer(function.call(interpreter, args, paren)))
+                result = std::move(*value);
+            else
+                error = "The result of the task can't be sent back.";
+        }
+        catch (const LoxRuntimeError &e)
+        {
+            error = std::string{e.what()} + " [line " + std::to_string(e.token.line) + "]";
+        }
+    }
+
+    const std::lock_guard lock{state.mutex};
+    state.done = true;
+    state.result = std::move(result);
+    state.error = std::move(error);
+    state.out = out.str();
+    state.err = err.str();
+    state.finished.notify_all();
+}
+
+// ---- parallel loops ----
+
+using compared_t = std::unordered_set<const void *>; // lists and maps of before already compared, for cycles
+
+// whether a copy made by transfer still holds what before holds, a call in a chunk could have changed it
+bool same(const lox::literal_t &before, const lox::literal_t &after, compared_t &compared)
+{
+    using namespace lox;
+
+    if (const LoxList::list_ptr *list = std::get_if<LoxList::list_ptr>(&before))
+    {
+        const LoxList::list_ptr *other = std::get_if<LoxList::list_ptr>(&after);
+        if (!other || (*list)->size() != (*other)->size())
+            return false;
+        if (!compared.insert(list->get()).second)
+            return true;
+
+        for (std::size_t i = 0; i < (*list)->size(); ++i)
+        {
+            if (!same((*list)->get(i), (*other)->get(i), compared))
+                return false;
+        }
+        return true;
+    }
+
+    if (const LoxMap::map_ptr *map = std::get_if<LoxMap::map_ptr>(&before))
+    {
+        const LoxMap::map_ptr *other = std::get_if<LoxMap::map_ptr>(&after);
+        if (!other || (*map)->size() != (*other)->size())
+            return false;
+        if (!compared.insert(map->get()).second)
+            return true;
+
+        bool equal = true;
+        (*map)->forEach([&](const literal_t &key, const literal_t &entry) {
+            const literal_t *found = (*other)->get(key);
+            equal = equal && found && same(entry, *found, compared);
+        });
+        return equal;
+    }
+
+    // nan isn't equal to itself
+    const double *number = std::get_if<double>(&before);
+    const double *otherNumber = std::get_if<double>(&after);
+    if (number && otherNumber && std::isnan(*number) && std::isnan(*otherNumber))
+        return true;
+
+    return before == after; // nil, bools, numbers, strings and channels
+}
+
+// the names that were copied into a chunk must still hold their values, a function called in the body could have
+// assigned or changed them, that would be lost with the chunk's copies
+void checkUnchanged(const std::vector<std::pair<std::string, lox::literal_t>> &copied, const lox::Environment &env,
+                    const std::string &accumulator, const lox::Token &token)
+{
+    for (const auto &[name, value] : copied)
+    {
+        if (name == accumulator)
+            continue;
+
+        compared_t compared;
+        const lox::literal_t *now = env.value(name);
+        if (!now || !same(value, *now, compared))
+        {
+            throw lox::LoxRuntimeError{
+                "Can't change '" + name + "' inside a parallel loop, it's shared by all iterations.", token};
+        }
+    }
+}
+
+constexpr std::uint64_t maxChunks = 64;          // plenty to balance the load on any machine, fixed for determinism
+constexpr std::uint64_t minChunkIterations = 16; // fewer don't make up for copying the program
+
+// one parallel loop, shared by the tasks that run its chunks
+struct ChunkedLoop
+{
+    struct Chunk
+    {
+        std::int64_t first{0}; // value of the counter in the first iteration
+        std::uint64_t iterations{0};
+        lox::literal_t partial;
+        std::optional<lox::LoxRuntimeError> error;
+        std::string out;
+        std::string err;
+    };
+
+    std::shared_ptr<const lox::Program> program; // the running program, for its functions and classes
+    std::shared_ptr<const lox::Program> body;
+    std::vector<std::pair<std::string, lox::literal_t>> globals;
+    std::vector<std::pair<std::string, lox::literal_t>> locals; // the enclosing scopes, flattened into one
+    const lox::ForStatement *loop;
+    lox::literal_t identity;
+
+    std::vector<Chunk> chunks;
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::size_t running{0};
+};
+
+// runs on the task pool, in an isolate of its own. the chunk is only touched by this task until it's done
+void runChunk(ChunkedLoop &loop, ChunkedLoop::Chunk &chunk)
+{
+    using namespace lox;
+
+    const Reduction &reduction = *loop.loop->_reduction;
+    const std::uint64_t step = static_cast<std::uint64_t>(loop.loop->_step);
+
+    std::ostringstream out;
+    std::ostringstream err;
+    ErrorHandler errors{err};
+    {
+        const std::unique_ptr<Program::Instance> instance = loop.program->instantiate(); // outlive the interpreter
+        const std::unique_ptr<Program::Instance> body = loop.body->instantiate();
+        Interpreter interpreter{out, errors};
+
+        try
+        {
+            // every chunk changes copies of its own
+            for (const auto &[name, value] : loop.globals)
+                interpreter.globals()->define(name, *transfer(value));
+
+            interpreter.declare(instance->statements(), loop.program);
+
+            const Environment::environment_ptr scope = std::make_shared<Environment>(interpreter.globals());
+            for (const auto &[name, value] : loop.locals)
+                scope->define(name, *transfer(value));
+
+            const Environment::environment_ptr accumulator = reduction.isGlobal ? interpreter.globals() : scope;
+            accumulator->define(reduction.accumulator, loop.identity);
+
+            for (std::uint64_t i = 0; i < chunk.iterations; ++i)
+            {
+                // a fresh counter per iteration, closures of different iterations don't share it
+                const Environment::environment_ptr counter = std::make_shared<Environment>(scope);
+                counter->define(loop.loop->_initializer->_name,
+                                static_cast<std::int64_t>(static_cast<std::uint64_t>(chunk.first) + i * step));
+
+                interpreter.executeBlock(body->statements(), counter);
+            }
+
+            const Token &counter = loop.loop->_initializer->_name;
+            checkUnchanged(loop.globals, *interpreter.globals(), reduction.isGlobal ? reduction.accumulator.lexeme : "",
+                           counter);
+            checkUnchanged(loop.locals, *scope, reduction.isGlobal ? "" : reduction.accumulator.lexeme, counter);
+
+            chunk.partial = *accumulator->value(reduction.accumulator.lexeme);
+        }
+        catch (const LoxRuntimeError &e)
+        {
+            chunk.error.emplace(e);
+        }
+    }
+
+    chunk.out = out.str();
+    chunk.err = err.str();
+
+    const std::lock_guard lock{loop.mutex};
+    --loop.running;
+    loop.finished.notify_all();
+}
+} // namespace
+
+lox::ThreadPool &lox::taskPool()
+{
+    // never destroyed, tasks that nobody joins may still be running at exit
+    static ThreadPool *const pool = new ThreadPool{};
+    return *pool;
+}
+
+std::optional<lox::literal_t> lox::transfer(const literal_t &value)
+{
+    copies_t copies;
+    return copy(value, copies);
+}
+
+// ---- parallel loops ----
+
+std::vector<lox::literal_t> lox::runChunks(Interpreter &interpreter, const ForStatement &loop,
+                                           const Environment::environment_ptr &scope, std::int64_t first,
+                                           std::uint64_t iterations, const literal_t &identity)
+{
+    if (iterations == 0)
+        return {};
+
+    const Reduction &reduction = *loop._reduction;
+    if (!reduction.body)
+    {
+        if (std::optional<std::string> image = AstCache::serialize(0, false, Statement::stmt_vec{loop._body}))
+            reduction.body = std::make_shared<const Program>(std::move(*image), 0, false);
+    }
+
+    const std::shared_ptr<ChunkedLoop> chunked = std::make_shared<ChunkedLoop>();
+    chunked->program = interpreter.program();
+    chunked->body = reduction.body;
+    if (!chunked->program || !chunked->body)
+        throw LoxRuntimeError{"The program can't be copied into a parallel loop.", loop._initializer->_name};
+
+    chunked->loop = &loop;
+    chunked->identity = identity;
+
+    // the values as they are now, the ones that can't cross are missing in the chunks
+    interpreter.globals()->forEach([&](const std::string &name, const literal_t &value) {
+        if (std::optional<literal_t> copied = transfer(value))
+            chunked->globals.emplace_back(name, std::move(*copied));
+    });
+
+    std::unordered_set<std::string> hidden; // by a variable of the same name in an inner scope
+    for (Environment::environment_ptr env = scope; env && env != interpreter.globals(); env = env->enclosing())
+    {
+        env->forEach([&](const std::string &name, const literal_t &value) {
+            if (!hidden.insert(name).second)
+                return;
+
+            if (std::optional<literal_t> copied = transfer(value))
+                chunked->locals.emplace_back(name, std::move(*copied));
+        });
+    }
+
+    // the first chunks take one iteration more, if they don't come out even
+    const std::uint64_t count = std::min(maxChunks, (iterations + minChunkIterations - 1) / minChunkIterations);
+    const std::uint64_t step = static_cast<std::uint64_t>(loop._step);
+    std::uint64_t done = 0;
+
+    chunked->chunks.resize(count);
+    for (std::uint64_t i = 0; i < count; ++i)
+    {
+        ChunkedLoop::Chunk &chunk = chunked->chunks[i];
+        chunk.first = static_cast<std::int64_t>(static_cast<std::uint64_t>(first) + done * step);
+        chunk.iterations = iterations / count + (i < iterations % count ? 1 : 0);
+        done += chunk.iterations;
+    }
+
+    chunked->running = count;
+    for (ChunkedLoop::Chunk &chunk : chunked->chunks)
+        taskPool().submit([chunked, &chunk] { runChunk(*chunked, chunk); });
+
+    {
+        std::unique_lock lock{chunked->mutex};
+        taskPool().block([&] { chunked->finished.wait(lock, [&] { return chunked->running == 0; }); });
+    }
+
+    // in order, as if the iterations had run one after the other
+    std::vector<literal_t> partials;
+    for (ChunkedLoop::Chunk &chunk : chunked->chunks)
+    {
+        interpreter.out() << chunk.out;
+        interpreter.errors().stream() << chunk.err;
+
+        if (chunk.error)
+            throw *chunk.error;
+
+        partials.push_back(std::move(chunk.partial));
+    }
+
+    return partials;
+}
+
+// ---- spawn ----
+
+lox::literal_t lox::SpawnFunction::call(Interpreter &interpreter, const std::vector<literal_t> &args,
+                                        const Token &paren) const
+{
+    if (args.empty())
+        throw LoxRuntimeError{"Expected a function to spawn.", paren};
+
+    // the task finds the function by its place in the program
+    const LoxFunction *function = nullptr;
+    if (const LoxCallable::callable_ptr *callable = std::get_if<LoxCallable::callable_ptr>(&args[0]))
+        function = dynamic_cast<const LoxFunction *>(callable->get());
+
+    const Statement::stmt_vec *stmts = interpreter.statements();
+    const bool topLevel = function && stmts && function->closure() == interpreter.globals();
+    std::size_t index = 0;
+    while (topLevel && index < stmts->size() && !declares((*stmts)[index], *function->declaration()))
+        ++index;
+
+    if (!topLevel || index == stmts->size())
+        throw LoxRuntimeError{"Can only spawn top level functions of the running program.", paren};
+
+    if (args.size() != static_cast<std::size_t>(function->arity()) + 1) // the function itself comes first
+    {
+        throw LoxRuntimeError{"Expected " + std::to_string(function->arity()) + " arguments but got " +
+                                  std::to_string(args.size() - 1) + ".",
+                              paren};
+    }
+
+    std::shared_ptr<const Program> program = interpreter.program();
+    if (!program)
+        throw LoxRuntimeError{"The program can't be copied into a task.", paren};
+
+    std::vector<literal_t> taskArgs;
+    for (std::size_t i = 1; i < args.size(); ++i)
+    {
+        std::optional<literal_t> arg = transfer(args[i]);
+        if (!arg)
+            throw LoxRuntimeError{"Argument " + std::to_string(i + 1) + " can't be sent to a task.", paren};
+
+        taskArgs.push_back(std::move(*arg));
+    }
+
+    // the globals as they are now, the ones that can't cross are missing in the task
+    std::vector<std::pair<std::string, literal_t>> globals;
+    interpreter.globals()->forEach([&](const std::string &name, const literal_t &value) {
+        if (std::optional<literal_t> copied = transfer(value))
+            globals.emplace_back(name, std::move(*copied));
+    });
+
+    const std::shared_ptr<LoxTask::State> state = std::make_shared<LoxTask::State>();
+    taskPool().submit([state, program, index, taskArgs, globals, paren] {
+        runTask(*state, program, index, taskArgs, globals, paren);
+    });
+
+    return std::make_shared<LoxTask>(state);
+}
+
+// ---- tasks ----
+
+lox::literal_t lox::LoxTask::call(Interpreter &, const std::vector<literal_t> &, const Token &paren) const
+{
+    throw LoxRuntimeError{"Can only call functions and classes.", paren};
+}
+
+lox::literal_t lox::LoxTask::join(Interpreter &interpreter) const
+{
+    std::unique_lock lock{_state->mutex};
+    taskPool().block([&] { _state->finished.wait(lock, [&] { return _state->done; }); });
+
+    // printed once, by the first join
+    interpreter.out() << _state->out;
+    interpreter.errors().stream() << _state->err;
+    _state->out.clear();
+    _state->err.clear();
+
+    if (!_state->error.empty())
+        throw NativeError{"Task failed: " + _state->error};
+
+    return _state->result;
+}
+
+// ---- channels ----
+
+lox::literal_t lox::LoxChannel::call(Interpreter &, const std::vector<literal_t> &, const Token &paren) const
+{
+    throw LoxRuntimeError{"Can only call functions and classes.", paren};
+}
+
+void lox::LoxChannel::send(const literal_t &value)
+{
+    std::optional<literal_t> copied = transfer(value);
+    if (!copied)
+        throw NativeError{"Only nil, bools, numbers, strings, lists, maps and channels can be sent."};
+
+    std::unique_lock lock{_mutex};
+    taskPool().block([&] { _changed.wait(lock, [&] { return _closed || _values.size() < _capacity; }); });
+
+    if (_closed)
+        throw NativeError{"Can't send to a closed channel."};
+
+    _values.push_back(std::move(*copied));
+    _changed.notify_all();
+}
+
+lox::literal_t lox::LoxChannel::receive()
+{
+    std::unique_lock lock{_mutex};
+    taskPool().block([&] { _changed.wait(lock, [&] { return _closed || !_values.empty(); }); });
+
+    if (_values.empty())
+        return nullptr;
+
+    literal_t value = std::move(_values.front());
+    _values.pop_front();
+    _changed.notify_all();
+    return value;
+}
+
+void lox::LoxChannel::close()
+{
+    const std::lock_guard lock{_mutex};
+    _closed = true;
+    _changed.notify_all();
+}
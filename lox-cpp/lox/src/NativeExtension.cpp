@@ -0,0 +1,131 @@
+#include "../include/types/NativeExtension.h"
+#include "../include/evaluating/Environment.h"
+#include "../include/types/Numbers.h"
+#include "../include/types/Throwables.h"
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+// what lox_native_api::registry points to while the entry point runs
+struct lox_registry
+{
+    lox::ExtensionFunction::library_ptr library;
+    std::vector<std::pair<std::string, lox::literal_t>> functions; // defined once the entry point succeeded
+};
+
+namespace
+{
+void defineExtensionFunction(lox_registry *registry, const char *name, int arity, lox_native_fn function,
+                             void *userdata)
+{
+    registry->functions.emplace_back(
+        name, std::make_shared<lox::ExtensionFunction>(name, arity, function, userdata, registry->library));
+}
+
+lox_value toNativeValue(const lox::literal_t &value, std::size_t index, const lox::Token &callSite)
+{
+    using namespace std;
+
+    if (holds_alternative<nullptr_t>(value))
+        return lox_nil();
+    if (holds_alternative<bool>(value))
+        return lox_bool(get<bool>(value));
+    if (lox::isNumber(value))
+        return lox_number(lox::toDouble(value));
+    if (holds_alternative<string>(value))
+    {
+        const string &str = get<string>(value); // stays alive during the call
+        return lox_string(str.c_str(), str.length());
+    }
+
+    throw lox::LoxRuntimeError{"Argument " + to_string(index + 1) + " can't be passed to a native extension.",
+                               callSite};
+}
+
+// ---- platform specific loading ----
+
+#ifdef _WIN32
+lox::ExtensionFunction::library_ptr openLibrary(const std::string &path)
+{
+    HMODULE handle = LoadLibraryA(path.c_str());
+    if (!handle)
+        throw lox::NativeError{"Couldn't load native extension '" + path + "'."};
+
+    return {handle, [](void *h) { FreeLibrary(static_cast<HMODULE>(h)); }};
+}
+
+void *findSymbol(void *library, const char *name)
+{
+    return reinterpret_cast<void *>(GetProcAddress(static_cast<HMODULE>(library), name));
+}
+#else
+lox::ExtensionFunction::library_ptr openLibrary(const std::string &path)
+{
+    void *handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle)
+        throw lox::NativeError{"Couldn't load native extension '" + path + "': " + dlerror()};
+
+    return {handle, [](void *h) { dlclose(h); }};
+}
+
+void *findSymbol(void *library, const char *name)
+{
+    return dlsym(library, name);
+}
+#endif
+} // namespace
+
+lox::literal_t lox::ExtensionFunction::call(Interpreter &, const std::vector<literal_t> &args, const Token &paren) const
+{
+    std::vector<lox_value> nativeArgs;
+    nativeArgs.reserve(args.size());
+    for (std::size_t i = 0; i < args.size(); ++i)
+        nativeArgs.push_back(toNativeValue(args[i], i, paren));
+
+    const lox_value result = _function(nativeArgs.data(), static_cast<int>(nativeArgs.size()), _userdata);
+
+    switch (result.type)
+    {
+    case LOX_BOOL:
+        return result.as.boolean != 0;
+    case LOX_NUMBER:
+        return result.as.number;
+    case LOX_STRING:
+        return std::string{result.as.string.chars, result.as.string.length};
+    case LOX_ERROR:
+        throw LoxRuntimeError{std::string{result.as.string.chars, result.as.string.length}, paren};
+    default:
+        return nullptr;
+    }
+}
+
+void lox::loadNativeExtension(Environment &environment, const std::string &path)
+{
+    ExtensionFunction::library_ptr library = openLibrary(path);
+
+    const auto init = reinterpret_cast<lox_native_init_fn>(findSymbol(library.get(), LOX_NATIVE_ENTRY_POINT));
+    if (!init)
+        throw NativeError{"'" + path + "' has no " + LOX_NATIVE_ENTRY_POINT + " entry point."};
+
+    lox_registry registry{library, {}};
+    const lox_native_api api{LOX_NATIVE_API_VERSION, &registry, &defineExtensionFunction};
+
+    if (init(&api) != 0)
+        throw NativeError{"Native extension '" + path + "' failed to initialize."};
+
+    // the static passes only see the assignments in the source, a global that changes its type behind their back
+    // would break what they proved about it (see TypeInference). so all of the functions or none
+    for (const auto &[name, function] : registry.functions)
+    {
+        if (environment.value(name))
+            throw NativeError{"Native extension '" + path + "' can't redefine '" + name + "'."};
+    }
+
+    for (const auto &[name, function] : registry.functions)
+        environment.define(name, function);
+}
@@ -0,0 +1,282 @@
+#include "../include/types/Natives.h"
+#include "../include/evaluating/Interpreter.h"
+#include "../include/types/LoxFuture.h"
+#include "../include/types/LoxList.h"
+#include "../include/types/LoxMap.h"
+#include "../include/types/LoxTask.h"
+#include "../include/types/NativeBinding.h"
+#include "../include/types/NativeExtension.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+double lox::natives::clock()
+{
+    using namespace std::chrono;
+
+    const auto timepoint = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+    return timepoint / 1000.0;
+}
+
+std::string lox::natives::input()
+{
+    std::string input;
+    std::getline(std::cin, input);
+    return input;
+}
+
+double lox::natives::number(const literal_t &value)
+{
+    if (std::holds_alternative<std::string>(value))
+    {
+        try
+        {
+            return std::stod(std::get<std::string>(value));
+        }
+        catch (std::exception &)
+        {
+            throw NativeError{"Couldn't convert to a number."};
+        }
+    }
+
+    if (std::holds_alternative<bool>(value))
+        return std::get<bool>(value) ? 1.0 : 0.0;
+
+    throw NativeError{"Only strings and bools are convertable to numbers."};
+}
+
+void lox::natives::loadNative(Interpreter &interpreter, const std::string &path)
+{
+    loadNativeExtension(*interpreter.globals(), path);
+}
+
+// ---- lists ----
+
+std::int64_t lox::natives::len(const literal_t &value)
+{
+    if (std::holds_alternative<std::string>(value))
+        return static_cast<std::int64_t>(std::get<std::string>(value).length());
+    if (std::holds_alternative<list_ptr>(value))
+        return static_cast<std::int64_t>(std::get<list_ptr>(value)->size());
+    if (std::holds_alternative<map_ptr>(value))
+        return static_cast<std::int64_t>(std::get<map_ptr>(value)->size());
+
+    throw NativeError{"Only strings, lists and maps have a length."};
+}
+
+lox::list_ptr lox::natives::list(double size, const literal_t &fill)
+{
+    if (size < 0 || std::floor(size) != size)
+        throw NativeError{"List size must be a non-negative integer."};
+
+    const std::size_t n = static_cast<std::size_t>(size);
+    if (isNumber(fill))
+        return std::make_shared<LoxList>(std::vector<double>(n, toDouble(fill)));
+
+    return std::make_shared<LoxList>(std::vector<literal_t>(n, fill));
+}
+
+void lox::natives::push(const list_ptr &list, const literal_t &value)
+{
+    list->push(value);
+}
+
+double lox::natives::sum(const list_ptr &list)
+{
+    return list->sum();
+}
+
+double lox::natives::min(const list_ptr &list)
+{
+    return list->min();
+}
+
+double lox::natives::max(const list_ptr &list)
+{
+    return list->max();
+}
+
+double lox::natives::dot(const list_ptr &a, const list_ptr &b)
+{
+    return a->dot(*b);
+}
+
+void lox::natives::scale(const list_ptr &list, double factor)
+{
+    list->scale(factor);
+}
+
+void lox::natives::sort(const list_ptr &list)
+{
+    list->sort();
+}
+
+// ---- maps ----
+
+namespace
+{
+void checkKey(const lox::literal_t &key)
+{
+    if (!lox::LoxMap::isValidKey(key))
+        throw lox::NativeError{"Map keys must be strings, numbers or bools."};
+}
+} // namespace
+
+lox::map_ptr lox::natives::map()
+{
+    return std::make_shared<LoxMap>();
+}
+
+lox::literal_t lox::natives::get(const map_ptr &map, const literal_t &key)
+{
+    checkKey(key);
+    const literal_t *value = map->get(key);
+    return value ? *value : nullptr;
+}
+
+void lox::natives::set(const map_ptr &map, const literal_t &key, const literal_t &value)
+{
+    checkKey(key);
+    map->set(key, value);
+}
+
+bool lox::natives::has(const map_ptr &map, const literal_t &key)
+{
+    checkKey(key);
+    return map->has(key);
+}
+
+bool lox::natives::remove(const map_ptr &map, const literal_t &key)
+{
+    checkKey(key);
+    return map->remove(key);
+}
+
+lox::list_ptr lox::natives::keys(const map_ptr &map)
+{
+    std::vector<literal_t> keys;
+    keys.reserve(map->size());
+    map->forEach([&](const literal_t &key, const literal_t &) { keys.push_back(key); });
+
+    return std::make_shared<LoxList>(std::move(keys));
+}
+
+lox::list_ptr lox::natives::values(const map_ptr &map)
+{
+    std::vector<literal_t> values;
+    values.reserve(map->size());
+    map->forEach([&](const literal_t &, const literal_t &value) { values.push_back(value); });
+
+    return std::make_shared<LoxList>(std::move(values));
+}
+
+// ---- tasks ----
+
+namespace
+{
+template <typename T> T &checkHandle(const lox::callable_ptr &handle, const char *message)
+{
+    T *target = dynamic_cast<T *>(handle.get());
+    if (!target)
+        throw lox::NativeError{message};
+
+    return *target;
+}
+} // namespace
+
+lox::literal_t lox::natives::join(Interpreter &interpreter, const callable_ptr &task)
+{
+    return checkHandle<LoxTask>(task, "Argument 1 must be a task.").join(interpreter);
+}
+
+lox::callable_ptr lox::natives::channel(double capacity)
+{
+    if (capacity < 1 || std::floor(capacity) != capacity)
+        throw NativeError{"Channel capacity must be a positive integer."};
+
+    return std::make_shared<LoxChannel>(static_cast<std::size_t>(capacity));
+}
+
+void lox::natives::send(const callable_ptr &channel, const literal_t &value)
+{
+    checkHandle<LoxChannel>(channel, "Argument 1 must be a channel.").send(value);
+}
+
+lox::literal_t lox::natives::receive(const callable_ptr &channel)
+{
+    return checkHandle<LoxChannel>(channel, "Argument 1 must be a channel.").receive();
+}
+
+void lox::natives::close(const callable_ptr &channel)
+{
+    checkHandle<LoxChannel>(channel, "Argument 1 must be a channel.").close();
+}
+
+// ---- async i/o ----
+
+lox::callable_ptr lox::natives::readFile(const std::string &path)
+{
+    return LoxFuture::readFile(path);
+}
+
+lox::callable_ptr lox::natives::readLine()
+{
+    return LoxFuture::readLine();
+}
+
+lox::callable_ptr lox::natives::sleep(double milliseconds)
+{
+    if (milliseconds < 0 || std::floor(milliseconds) != milliseconds)
+        throw NativeError{"Sleep time must be a non-negative integer."};
+
+    return LoxFuture::sleep(static_cast<std::int64_t>(milliseconds));
+}
+
+lox::literal_t lox::natives::await(const callable_ptr &future)
+{
+    return checkHandle<LoxFuture>(future, "Argument 1 must be a future.").await();
+}
+
+bool lox::natives::ready(const callable_ptr &future)
+{
+    return checkHandle<LoxFuture>(future, "Argument 1 must be a future.").ready();
+}
+
+void lox::defineNatives(Environment &globals)
+{
+    bindNative(globals, "clock", &natives::clock);
+    bindNative(globals, "input", &natives::input);
+    bindNative(globals, "number", &natives::number);
+    bindNative(globals, "loadNative", &natives::loadNative);
+
+    bindNative(globals, "len", &natives::len);
+    bindNative(globals, "list", &natives::list);
+    bindNative(globals, "push", &natives::push);
+    bindNative(globals, "sum", &natives::sum);
+    bindNative(globals, "min", &natives::min);
+    bindNative(globals, "max", &natives::max);
+    bindNative(globals, "dot", &natives::dot);
+    bindNative(globals, "scale", &natives::scale);
+    bindNative(globals, "sort", &natives::sort);
+
+    bindNative(globals, "map", &natives::map);
+    bindNative(globals, "get", &natives::get);
+    bindNative(globals, "set", &natives::set);
+    bindNative(globals, "has", &natives::has);
+    bindNative(globals, "remove", &natives::remove);
+    bindNative(globals, "keys", &natives::keys);
+    bindNative(globals, "values", &natives::values);
+
+    globals.define("spawn", std::make_shared<SpawnFunction>());
+    bindNative(globals, "join", &natives::join);
+    bindNative(globals, "channel", &natives::channel);
+    bindNative(globals, "send", &natives::send);
+    bindNative(globals, "receive", &natives::receive);
+    bindNative(globals, "close", &natives::close);
+
+    bindNative(globals, "readFile", &natives::readFile);
+    bindNative(globals, "readLine", &natives::readLine);
+    bindNative(globals, "sleep", &natives::sleep);
+    bindNative(globals, "await", &natives::await);
+    bindNative(globals, "ready", &natives::ready);
+}
@@ -1,15 +1,44 @@
 #include "../include/parsing/Parser.h"
 #include "../include/ErrorHandler.h"
+#include <limits>
+#include <optional>
 
 using namespace lox;
 
+namespace
+{
+// step of "name = name + step" / "name = name - step" with an int literal step, if increment has that shape
+std::optional<std::int64_t> counterStep(const Token &name, const Expression::expr_ptr &increment)
+{
+    const AssignExpression *assign = dynamic_cast<const AssignExpression *>(increment.get());
+    if (!assign || assign->_name.lexeme != name.lexeme)
+        return std::nullopt;
+
+    const BinaryExpression *sum = dynamic_cast<const BinaryExpression *>(assign->_value.get());
+    if (!sum || (sum->_operator.type != TokenType::PLUS && sum->_operator.type != TokenType::MINUS))
+        return std::nullopt;
+
+    const VarExpression *self = dynamic_cast<const VarExpression *>(sum->_left.get());
+    const LiteralExpression *step = dynamic_cast<const LiteralExpression *>(sum->_right.get());
+    if (!self || self->_name.lexeme != name.lexeme || !step || !std::holds_alternative<std::int64_t>(step->_value))
+        return std::nullopt;
+
+    const std::int64_t value = std::get<std::int64_t>(step->_value);
+    if (sum->_operator.type == TokenType::PLUS)
+        return value;
+    if (value == std::numeric_limits<std::int64_t>::min())
+        return std::nullopt;
+    return -value;
+}
+} // namespace
+
 Statement::stmt_vec Parser::parse()
 {
     Statement::stmt_vec stmts; // shorthand for statements
 
     while (!isAtEnd())
     {
-        stmts.push_back(declaration()); // every line in the program is a declaration
+        stmts.push_back(declaration(true)); // every line in the program is a declaration
     }
 
     return stmts;
@@ -19,12 +48,16 @@ Statement::stmt_vec Parser::parse()
 
 // ----------- parse statements -------------
 
-Statement::stmt_ptr lox::Parser::declaration()
+Statement::stmt_ptr lox::Parser::declaration(bool topLevel)
 {
     try
     {
+        if (match(TokenType::CLASS))
+            return classDeclaration();
+
+        // only top level functions can be lazy, their body is resolved without any enclosing scopes
         if (match(TokenType::FUN))
-            return function();
+            return function(topLevel && _lazy);
 
         if (match(TokenType::VAR))
             return varDeclaration();
@@ -38,6 +71,28 @@ Statement::stmt_ptr lox::Parser::declaration()
     }
 }
 
+Statement::stmt_ptr lox::Parser::classDeclaration()
+{
+    using enum TokenType;
+    const Token name = consume(IDENTIFIER, "Expect class name.");
+
+    std::shared_ptr<VarExpression> superclass;
+    if (match(LESS))
+    {
+        consume(IDENTIFIER, "Expect superclass name.");
+        superclass = std::make_shared<VarExpression>(previous());
+    }
+
+    consume(LEFT_BRACE, "Expect '{' before class body.");
+
+    std::vector<ClassStatement::function_ptr> methods;
+    while (!check(RIGHT_BRACE) && !isAtEnd())
+        methods.push_back(std::static_pointer_cast<FunctionStatement>(function()));
+
+    consume(RIGHT_BRACE, "Expect '}' after class body.");
+    return std::make_shared<ClassStatement>(name, superclass, methods);
+}
+
 Statement::stmt_ptr lox::Parser::varDeclaration()
 {
     Token name = consume(TokenType::IDENTIFIER, "Expect variable name.");
@@ -50,7 +105,7 @@ Statement::stmt_ptr lox::Parser::varDeclaration()
     return std::make_shared<VarStatement>(name, initializer);
 }
 
-Statement::stmt_ptr lox::Parser::function()
+Statement::stmt_ptr lox::Parser::function(bool lazy)
 {
     using enum TokenType;
     const Token name = consume(IDENTIFIER, "Expect function/method name.");
@@ -70,10 +125,54 @@ Statement::stmt_ptr lox::Parser::function()
     consume(RIGHT_PAREN, "Expect ')' after parameters.");
     consume(LEFT_BRACE, "Expect '{' before function/method body.");
 
+    if (lazy)
+    {
+        if (std::shared_ptr<LazyBody> body = skipBody())
+            return std::make_shared<FunctionStatement>(name, params, body);
+    }
+
     Statement::stmt_vec body = block();
     return std::make_shared<FunctionStatement>(name, params, body);
 }
 
+std::shared_ptr<LazyBody> lox::Parser::skipBody()
+{
+    using enum TokenType;
+
+    std::size_t end = _current;
+    for (int depth = 0; depth > 0 || _tokens.at(end).type != RIGHT_BRACE; ++end)
+    {
+        const TokenType type = _tokens.at(end).type;
+        if (type == Eof)
+            return nullptr; // let block() report the missing brace
+        if (type == LEFT_BRACE)
+            ++depth;
+        else if (type == RIGHT_BRACE)
+            --depth;
+    }
+
+    if (end - _current < minLazyTokens)
+        return nullptr;
+
+    std::shared_ptr<LazyBody> body = std::make_shared<LazyBody>();
+    body->tokens.reserve(end - _current + 1);
+    for (std::size_t i = _current; i < end; ++i)
+        body->tokens.push_back(_tokens[i]);
+    body->tokens.push_back(Token{Eof, "", nullptr, _tokens[end].line});
+
+    // name = ..., but not object.name = ...
+    for (std::size_t i = _current; i + 1 < end; ++i)
+    {
+        if (_tokens[i].type == IDENTIFIER && _tokens[i + 1].type == EQUAL && (i == 0 || _tokens[i - 1].type != DOT))
+            body->assigned.insert(_tokens[i].lexeme);
+    }
+
+    ++_lazyBodies;
+    _lazyTokens += end - _current;
+    _current = static_cast<int>(end) + 1; // behind the closing brace
+    return body;
+}
+
 Statement::stmt_vec lox::Parser::block()
 {
     using TokenType::RIGHT_BRACE;
@@ -93,6 +192,14 @@ Statement::stmt_ptr Parser::statement()
     if (match(FOR))
         return forStatement();
 
+    // 'parallel' is no keyword, it only means something right in front of a for
+    if (check(IDENTIFIER) && peek().lexeme == "parallel" && _tokens.at(_current + 1).type == FOR)
+    {
+        advance();
+        advance();
+        return forStatement(true);
+    }
+
     if (match(IF))
         return ifStatement();
 
@@ -107,8 +214,9 @@ Statement::stmt_ptr Parser::statement()
 
     if (match(BREAK))
     {
+        const Token keyword = previous();
         consume(SEMICOLON, "Expect ';' after 'break'.");
-        return std::make_shared<BreakStatement>();
+        return std::make_shared<BreakStatement>(keyword);
     }
 
     if (match(LEFT_BRACE)) // block statement
@@ -128,9 +236,10 @@ Statement::stmt_ptr Parser::expressionStatement()
     return std::make_shared<ExpressionStatement>(expr);
 }
 
-Statement::stmt_ptr lox::Parser::forStatement()
+Statement::stmt_ptr lox::Parser::forStatement(bool parallel)
 {
     using enum TokenType;
+    const Token keyword = previous();
     consume(LEFT_PAREN, "Expect '(' after 'for'.");
 
     Statement::stmt_ptr initializer;
@@ -153,8 +262,36 @@ Statement::stmt_ptr lox::Parser::forStatement()
         increment = expression();
 
     consume(RIGHT_PAREN, "Expect ')' after clauses.");
+    const std::shared_ptr<Reduction> reduction = parallel ? this->reduction() : nullptr;
     Statement::stmt_ptr body = statement();
 
+    // ---- canonical counter: for (var i = start; i < bound; i = i + step) ----
+
+    std::shared_ptr<VarStatement> counter = std::dynamic_pointer_cast<VarStatement>(initializer);
+    const BinaryExpression *comparison = dynamic_cast<const BinaryExpression *>(condition.get());
+    if (counter && comparison)
+    {
+        const VarExpression *var = dynamic_cast<const VarExpression *>(comparison->_left.get());
+        const TokenType op = comparison->_operator.type;
+        const bool isComparison = op == LESS || op == LESS_EQUAL || op == GREATER || op == GREATER_EQUAL;
+
+        if (var && var->_name.lexeme == counter->_name.lexeme && isComparison)
+        {
+            const std::optional<std::int64_t> step = counterStep(counter->_name, increment);
+            const bool upwards = (op == LESS || op == LESS_EQUAL) && step && *step > 0;
+
+            if (step && (!reduction || upwards))
+            {
+                const Expression::expr_ptr bound = comparison->_right;
+                return std::make_shared<ForStatement>(counter, condition, increment, body, bound,
+                                                      comparison->_operator, *step, reduction);
+            }
+        }
+    }
+
+    if (reduction) // reported, the loop still gets desugared to keep parsing
+        error(keyword, "Expect a loop like 'for (var i = a; i < b; i = i + 1)' after 'parallel'.");
+
     // ---- desugaring ----
 
     if (increment) // make var increment in while loop
@@ -187,6 +324,26 @@ Statement::stmt_ptr lox::Parser::forStatement()
     return body;
 }
 
+std::shared_ptr<Reduction> lox::Parser::reduction()
+{
+    using enum TokenType;
+
+    // contextual like 'parallel', reduce is still a valid name everywhere else
+    if (!check(IDENTIFIER) || peek().lexeme != "reduce")
+    {
+        error(peek(), "Expect 'reduce' after the clauses of a parallel loop.");
+        throw std::runtime_error{"Expect 'reduce' after the clauses of a parallel loop."};
+    }
+    advance();
+
+    consume(LEFT_PAREN, "Expect '(' after 'reduce'.");
+    const Token op = match({PLUS, STAR}) ? previous() : consume(PLUS, "Expect '+' or '*' to reduce with.");
+    consume(RIGHT_PAREN, "Expect ')' after the reduction operator.");
+    const Token accumulator = consume(IDENTIFIER, "Expect the name of the accumulator after the reduction.");
+
+    return std::make_shared<Reduction>(Reduction{op, accumulator});
+}
+
 Statement::stmt_ptr lox::Parser::ifStatement()
 {
     using enum TokenType;
@@ -258,7 +415,19 @@ Expression::expr_ptr lox::Parser::assignment()
             return std::make_shared<AssignExpression>(var->_name, value);
         }
 
-        ErrorHandler::error(equals_op, "Invalid assignment target.");
+        // object.field = value
+        if (GetExpression *get = dynamic_cast<GetExpression *>(expr.get()))
+        {
+            return std::make_shared<SetExpression>(get->_object, get->_name, value);
+        }
+
+        // list[index] = value
+        if (IndexExpression *index = dynamic_cast<IndexExpression *>(expr.get()))
+        {
+            return std::make_shared<IndexAssignExpression>(index->_object, index->_bracket, index->_index, value);
+        }
+
+        error(equals_op, "Invalid assignment target.");
     }
 
     return expr;
@@ -373,6 +542,17 @@ Expression::expr_ptr lox::Parser::call()
     {
         if (match(TokenType::LEFT_PAREN))
             expr = finishCall(expr);
+        else if (match(TokenType::DOT))
+        {
+            const Token name = consume(TokenType::IDENTIFIER, "Expect property name after '.'.");
+            expr = std::make_shared<GetExpression>(expr, name);
+        }
+        else if (match(TokenType::LEFT_BRACKET))
+        {
+            Expression::expr_ptr index = expression();
+            const Token bracket = consume(TokenType::RIGHT_BRACKET, "Expect ']' after index.");
+            expr = std::make_shared<IndexExpression>(expr, bracket, index);
+        }
         else
             break;
     }
@@ -395,10 +575,37 @@ Expression::expr_ptr lox::Parser::primary()
     if (match({NUMBER, STRING}))
         return std::make_shared<LiteralExpression>(literal_t{previous().literal});
 
+    if (match(THIS))
+        return std::make_shared<ThisExpression>(previous());
+
+    if (match(SUPER))
+    {
+        const Token keyword = previous();
+        consume(DOT, "Expect '.' after 'super'.");
+        const Token method = consume(IDENTIFIER, "Expect superclass method name.");
+        return std::make_shared<SuperExpression>(keyword, method);
+    }
+
     // variables
     if (match(IDENTIFIER))
         return std::make_shared<VarExpression>(previous());
 
+    // list literal
+    if (match(LEFT_BRACKET))
+    {
+        Expression::expr_vec elements;
+        if (!check(RIGHT_BRACKET))
+        {
+            do
+            {
+                elements.push_back(expression());
+            } while (match(COMMA));
+        }
+
+        consume(RIGHT_BRACKET, "Expect ']' after list elements.");
+        return std::make_shared<ListExpression>(elements);
+    }
+
     // grouping stuff
     if (match(LEFT_PAREN))
     {
@@ -408,7 +615,7 @@ Expression::expr_ptr lox::Parser::primary()
     }
 
     constexpr char message[] = "Expect expression.";
-    ErrorHandler::error(peek(), message);
+    error(peek(), message);
     throw std::runtime_error(message);
 }
 
@@ -483,10 +690,16 @@ Token lox::Parser::consume(TokenType type, const std::string &&message)
     if (check(type))
         return advance();
 
-    ErrorHandler::error(peek(), message);
+    error(peek(), message);
     throw std::runtime_error{message};
 }
 
+void lox::Parser::error(const Token &token, const std::string &message)
+{
+    _errors.error(token, message);
+    _hadError = true;
+}
+
 bool Parser::check(TokenType t) const
 {
     if (isAtEnd())
@@ -0,0 +1,187 @@
+#include "../include/Profiler.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <system_error>
+#include <thread>
+
+lox::Profiler::Profiler(int hertz)
+    : _slots{std::make_unique<Slot[]>(tableSize)}, _names{std::make_unique<Name[]>(namesSize)}
+{
+    _active.store(this, std::memory_order_release);
+    _sampling.store(true, std::memory_order_relaxed);
+
+    struct sigaction action{};
+    action.sa_handler = &Profiler::sample;
+    action.sa_flags = SA_RESTART; // the interrupted system calls just go on
+    sigemptyset(&action.sa_mask);
+
+    // a posix timer on the cpu time of the process, setitimer only ticks with the scheduler
+    sigevent event{};
+    event.sigev_notify = SIGEV_SIGNAL;
+    event.sigev_signo = SIGPROF;
+
+    itimerspec interval{};
+    interval.it_interval.tv_nsec = 1'000'000'000 / std::max(hertz, 1);
+    interval.it_value = interval.it_interval;
+
+    if (sigaction(SIGPROF, &action, nullptr) != 0 || timer_create(CLOCK_PROCESS_CPUTIME_ID, &event, &_timer) != 0)
+        throw std::system_error{errno, std::generic_category(), "profiler"};
+    timer_settime(_timer, 0, &interval, nullptr);
+}
+
+lox::Profiler::~Profiler()
+{
+    stop();
+}
+
+void lox::Profiler::write(std::ostream &out)
+{
+    stop();
+
+    // the table can have the same stack twice, when a name didn't fit anymore
+    std::map<std::string, std::uint64_t> folded;
+    for (std::size_t i = 0; i < tableSize; ++i)
+    {
+        const Slot &slot = _slots[i];
+        if (!slot.ready.load(std::memory_order_acquire))
+            continue;
+
+        std::string stack = "<script>";
+        for (int call = 0; call < slot.depth; ++call)
+        {
+            const int name = slot.calls[call].name;
+            stack += ";" + (name < 0 ? std::string{"?"} : std::string{_names[name].text}) + ":" +
+                     std::to_string(slot.calls[call].line);
+        }
+
+        folded[stack] += slot.count.load(std::memory_order_relaxed);
+    }
+
+    for (const auto &[stack, count] : folded)
+        out << stack << " " << count << "\n";
+}
+
+// ---- private area -----
+
+void lox::Profiler::sample(int)
+{
+    const int saved = errno;
+    _handlers.fetch_add(1, std::memory_order_acquire);
+
+    if (Profiler *profiler = _active.load(std::memory_order_acquire))
+        profiler->record(_stack);
+
+    _handlers.fetch_sub(1, std::memory_order_release);
+    errno = saved;
+}
+
+void lox::Profiler::record(const Stack &stack)
+{
+    const int depth = std::min(stack.depth.load(std::memory_order_relaxed), maxDepth);
+    std::atomic_signal_fence(std::memory_order_acquire);
+
+    // the same function can be in several ASTs (isolates), its calls come together by name
+    Sampled calls[maxDepth];
+    std::uint64_t hash = 14695981039346656037ull; // FNV-1a over the calls
+    for (int i = 0; i < depth; ++i)
+    {
+        calls[i] = Sampled{intern(*stack.calls[i].name), stack.calls[i].line};
+        hash = (hash ^ static_cast<std::uint64_t>(calls[i].name)) * 1099511628211ull;
+        hash = (hash ^ static_cast<std::uint64_t>(calls[i].line)) * 1099511628211ull;
+    }
+    hash = std::max<std::uint64_t>(hash, 1);
+
+    _samples.fetch_add(1, std::memory_order_relaxed);
+
+    const auto sameCalls = [&](const Slot &slot) {
+        return slot.depth == depth && std::equal(calls, calls + depth, slot.calls, [](Sampled a, Sampled b) {
+                   return a.name == b.name && a.line == b.line;
+               });
+    };
+
+    for (std::size_t probe = 0; probe < tableSize; ++probe)
+    {
+        Slot &slot = _slots[(hash + probe) & (tableSize - 1)];
+        std::uint64_t taken = slot.hash.load(std::memory_order_acquire);
+
+        if (taken == 0 && slot.hash.compare_exchange_strong(taken, hash, std::memory_order_acq_rel))
+        {
+            slot.depth = depth;
+            std::copy(calls, calls + depth, slot.calls);
+            slot.ready.store(true, std::memory_order_release);
+            slot.count.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        if (taken == hash)
+        {
+            while (!slot.ready.load(std::memory_order_acquire))
+                ; // another thread is writing the calls, a handful of stores
+
+            if (sameCalls(slot))
+            {
+                slot.count.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+    _dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+// the index of the name in the table, it's copied there the first time. only what a signal handler may do
+int lox::Profiler::intern(const std::string &name)
+{
+    const std::size_t length = std::min(name.size(), maxName - 1);
+
+    std::uint64_t hash = 14695981039346656037ull;
+    for (std::size_t i = 0; i < length; ++i)
+        hash = (hash ^ static_cast<unsigned char>(name[i])) * 1099511628211ull;
+    hash = std::max<std::uint64_t>(hash, 1);
+
+    for (std::size_t probe = 0; probe < namesSize; ++probe)
+    {
+        const std::size_t index = (hash + probe) & (namesSize - 1);
+        Name &entry = _names[index];
+        std::uint64_t taken = entry.hash.load(std::memory_order_acquire);
+
+        if (taken == 0 && entry.hash.compare_exchange_strong(taken, hash, std::memory_order_acq_rel))
+        {
+            std::copy(name.data(), name.data() + length, entry.text);
+            entry.text[length] = '\0';
+            entry.ready.store(true, std::memory_order_release);
+            return static_cast<int>(index);
+        }
+
+        if (taken == hash)
+        {
+            while (!entry.ready.load(std::memory_order_acquire))
+                ; // another thread is copying the name
+
+            if (std::strlen(entry.text) == length && std::equal(name.data(), name.data() + length, entry.text))
+                return static_cast<int>(index);
+        }
+    }
+
+    return -1;
+}
+
+void lox::Profiler::stop()
+{
+    if (!_running)
+        return;
+    _running = false;
+
+    // the handler stays, a signal that is on its way already finds no profiler (the default would end the process)
+    timer_delete(_timer);
+
+    _sampling.store(false, std::memory_order_relaxed);
+    _active.store(nullptr, std::memory_order_release);
+
+    // a handler on another thread may still be counting
+    while (_handlers.load(std::memory_order_acquire) > 0)
+        std::this_thread::yield();
+}
@@ -0,0 +1,26 @@
+#include "../include/Program.h"
+#include "../include/parsing/AstCache.h"
+
+std::unique_ptr<lox::Program::Instance> lox::Program::instantiate() const
+{
+    {
+        const std::lock_guard lock{_mutex};
+        if (!_idle.empty())
+        {
+            Statement::stmt_vec stmts = std::move(_idle.back());
+            _idle.pop_back();
+            return std::make_unique<Instance>(*this, std::move(stmts));
+        }
+    }
+
+    // outside of the lock, the other threads keep going while this one builds
+    return std::make_unique<Instance>(*this, AstCache::deserialize(_image, _hash, _lazy));
+}
+
+// ---- private area -----
+
+void lox::Program::release(Statement::stmt_vec stmts) const
+{
+    const std::lock_guard lock{_mutex};
+    _idle.push_back(std::move(stmts));
+}
@@ -0,0 +1,393 @@
+#include "../include/evaluating/Resolver.h"
+#include "../include/ErrorHandler.h"
+#include <array>
+#include <string_view>
+
+namespace
+{
+// natives that change their first argument in place
+constexpr std::array<std::string_view, 5> changingNatives{"push", "scale", "sort", "set", "remove"};
+} // namespace
+
+void lox::Resolver::resolve(const Statement::stmt_vec &stmts)
+{
+    for (const Statement::stmt_ptr &stmt : stmts)
+        resolve(stmt);
+}
+
+// ----------- resolve statements ------------
+
+void lox::Resolver::visitIfStmt(const IfStatement &stmt)
+{
+    resolve(stmt._condition);
+    resolve(stmt._thenBranch);
+    resolve(stmt._elseBranch);
+}
+
+void lox::Resolver::visitBlockStmt(const BlockStatement &stmt)
+{
+    beginScope(stmt._statements);
+    resolve(stmt._statements);
+    endScope();
+}
+
+void lox::Resolver::visitClassStmt(const ClassStatement &stmt)
+{
+    const ClassType enclosingClass = _currentClass;
+    _currentClass = ClassType::CLASS;
+
+    if (stmt._superclass)
+    {
+        if (stmt._superclass->_name.lexeme == stmt._name.lexeme)
+            _errors.error(stmt._superclass->_name, "A class can't inherit from itself.");
+
+        _currentClass = ClassType::SUBCLASS;
+        resolve(stmt._superclass);
+    }
+
+    // instances of a class declared inside a parallel loop belong to the iteration
+    const bool ownClass = _parallel.ownClass;
+    _parallel.ownClass = _parallel.reduction != nullptr;
+
+    for (const ClassStatement::function_ptr &method : stmt._methods)
+        resolveFunction(*method, method->_name.lexeme == "init" ? FunctionType::INITIALIZER : FunctionType::METHOD);
+
+    _parallel.ownClass = ownClass;
+    _currentClass = enclosingClass;
+}
+
+void lox::Resolver::visitExpressionStmt(const ExpressionStatement &stmt)
+{
+    resolve(stmt._expr);
+}
+
+void lox::Resolver::visitFunctionStatement(const FunctionStatement &stmt)
+{
+    resolveFunction(stmt, FunctionType::FUNCTION);
+}
+
+void lox::Resolver::visitVarStmt(const VarStatement &stmt)
+{
+    resolve(stmt._initializer);
+}
+
+void lox::Resolver::visitPrintStmt(const PrintStatement &stmt)
+{
+    resolve(stmt._expr);
+}
+
+void lox::Resolver::visitReturnStmt(const ReturnStatement &stmt)
+{
+    if (_parallel.reduction && _parallel.functions == 0)
+        _errors.error(stmt._keyword, "Can't return from inside a parallel loop.");
+    if (stmt._value && _currentFunction == FunctionType::INITIALIZER)
+        _errors.error(stmt._keyword, "Can't return a value from an initializer.");
+
+    resolve(stmt._value);
+}
+
+void lox::Resolver::visitWhileStmt(const WhileStatement &stmt)
+{
+    resolve(stmt._condition);
+
+    ++_parallel.loops;
+    resolve(stmt._body);
+    --_parallel.loops;
+}
+
+void lox::Resolver::visitForStmt(const ForStatement &stmt)
+{
+    // the counter has its own scope around the loop
+    beginScope({stmt._initializer});
+    resolve(stmt._initializer);
+    resolve(stmt._condition);
+    resolve(stmt._increment);
+
+    const Parallel enclosing = _parallel;
+    if (stmt._reduction)
+    {
+        // a parallel loop inside of another one accumulates into a variable of the outer one
+        checkParallelAssign(stmt._reduction->accumulator);
+        stmt._reduction->isGlobal = isGlobal(stmt._reduction->accumulator);
+        _parallel = Parallel{stmt._reduction.get(), _scopes.size()};
+    }
+    else
+        ++_parallel.loops;
+
+    resolve(stmt._body);
+    _parallel = enclosing;
+    endScope();
+}
+
+void lox::Resolver::visitBreakStmt(const BreakStatement &stmt)
+{
+    if (_parallel.reduction && _parallel.loops == 0)
+        _errors.error(stmt._keyword, "Can't break out of a parallel loop.");
+}
+
+// ----------- resolve expressions ------------
+
+void lox::Resolver::visitAssignExpr(const AssignExpression &expr)
+{
+    checkParallelAssign(expr._name);
+
+    // acc = acc op value, the only way to use the accumulator
+    const BinaryExpression *binary = dynamic_cast<const BinaryExpression *>(expr._value.get());
+    if (isAccumulator(expr._name))
+    {
+        const VarExpression *self = binary ? dynamic_cast<const VarExpression *>(binary->_left.get()) : nullptr;
+        const bool fromSelf = self && self->_name.lexeme == expr._name.lexeme;
+        if (fromSelf)
+            _accumulating = self; // reported once, even with the wrong operator
+
+        if (!fromSelf || binary->_operator.type != _parallel.reduction->op.type)
+            _errors.error(expr._name, "Can only accumulate into '" + expr._name.lexeme + "' with '" +
+                                          _parallel.reduction->op.lexeme + "' inside its parallel loop.");
+    }
+
+    resolve(expr._value);
+    expr._isGlobal = isGlobal(expr._name);
+}
+
+void lox::Resolver::visitBinaryExpr(const BinaryExpression &expr)
+{
+    resolve(expr._left);
+    resolve(expr._right);
+}
+
+void lox::Resolver::visitCallExpr(const CallExpression &expr)
+{
+    const VarExpression *callee = dynamic_cast<const VarExpression *>(expr._callee.get());
+    if (_parallel.reduction && callee && !expr._args.empty() && isGlobal(callee->_name))
+    {
+        for (const std::string_view name : changingNatives)
+        {
+            if (callee->_name.lexeme == name)
+                checkParallelChange(expr._args[0]);
+        }
+    }
+
+    resolve(expr._callee); // calls to global functions use the callee's cache
+
+    for (const Expression::expr_ptr &arg : expr._args)
+        resolve(arg);
+}
+
+void lox::Resolver::visitGetExpr(const GetExpression &expr)
+{
+    resolve(expr._object);
+}
+
+void lox::Resolver::visitGroupingExpr(const GroupingExpression &expr)
+{
+    resolve(expr._expression);
+}
+
+void lox::Resolver::visitIndexExpr(const IndexExpression &expr)
+{
+    resolve(expr._object);
+    resolve(expr._index);
+}
+
+void lox::Resolver::visitIndexAssignExpr(const IndexAssignExpression &expr)
+{
+    checkParallelChange(expr._object);
+    resolve(expr._object);
+    resolve(expr._index);
+    resolve(expr._value);
+}
+
+void lox::Resolver::visitListExpr(const ListExpression &expr)
+{
+    for (const Expression::expr_ptr &element : expr._elements)
+        resolve(element);
+}
+
+void lox::Resolver::visitLiteralExpr(const LiteralExpression &)
+{
+    // EMPTY
+}
+
+void lox::Resolver::visitLogicalExpr(const LogicalExpression &expr)
+{
+    resolve(expr._left);
+    resolve(expr._right);
+}
+
+void lox::Resolver::visitSetExpr(const SetExpression &expr)
+{
+    checkParallelChange(expr._object);
+    resolve(expr._value);
+    resolve(expr._object);
+}
+
+void lox::Resolver::visitSuperExpr(const SuperExpression &expr)
+{
+    if (_currentClass == ClassType::NONE)
+        _errors.error(expr._keyword, "Can't use 'super' outside of a class.");
+    else if (_currentClass != ClassType::SUBCLASS)
+        _errors.error(expr._keyword, "Can't use 'super' in a class with no superclass.");
+}
+
+void lox::Resolver::visitThisExpr(const ThisExpression &expr)
+{
+    if (_currentClass == ClassType::NONE)
+        _errors.error(expr._keyword, "Can't use 'this' outside of a class.");
+}
+
+void lox::Resolver::visitUnaryExpr(const UnaryExpression &expr)
+{
+    resolve(expr._right);
+}
+
+void lox::Resolver::visitVarExpr(const VarExpression &expr)
+{
+    if (isAccumulator(expr._name) && &expr != _accumulating)
+        _errors.error(expr._name, "Can only accumulate into '" + expr._name.lexeme + "' with '" +
+                                      _parallel.reduction->op.lexeme + "' inside its parallel loop.");
+
+    expr._isGlobal = isGlobal(expr._name);
+}
+
+void lox::Resolver::visitIncrementExpr(const IncrementExpression &expr)
+{
+    expr._isGlobal = isGlobal(expr._name);
+}
+
+void lox::Resolver::visitCompareConstExpr(const CompareConstExpression &expr)
+{
+    expr._isGlobal = isGlobal(expr._name);
+}
+
+void lox::Resolver::visitAssignBinaryExpr(const AssignBinaryExpression &expr)
+{
+    resolve(expr._right);
+    expr._isGlobal = isGlobal(expr._name);
+}
+
+void lox::Resolver::visitLiteralCallExpr(const LiteralCallExpression &expr)
+{
+    resolve(expr._call);
+}
+
+// ---- private area -----
+
+void lox::Resolver::resolve(const Statement::stmt_ptr &stmt)
+{
+    if (stmt)
+        stmt->accept(*this);
+}
+
+void lox::Resolver::resolve(const Expression::expr_ptr &expr)
+{
+    if (expr)
+        expr->accept(*this);
+}
+
+void lox::Resolver::beginScope(const Statement::stmt_vec &stmts, const std::vector<Token> &params)
+{
+    std::unordered_set<std::string> &scope = _scopes.emplace_back();
+
+    for (const Token &param : params)
+        scope.insert(param.lexeme);
+
+    // only direct children declare variables in this scope, nested blocks get their own
+    for (const Statement::stmt_ptr &stmt : stmts)
+    {
+        if (const VarStatement *var = dynamic_cast<const VarStatement *>(stmt.get()))
+            scope.insert(var->_name.lexeme);
+        else if (const FunctionStatement *fun = dynamic_cast<const FunctionStatement *>(stmt.get()))
+            scope.insert(fun->_name.lexeme);
+        else if (const ClassStatement *klass = dynamic_cast<const ClassStatement *>(stmt.get()))
+            scope.insert(klass->_name.lexeme);
+    }
+}
+
+void lox::Resolver::endScope()
+{
+    _scopes.pop_back();
+}
+
+bool lox::Resolver::isGlobal(const Token &name) const
+{
+    for (const auto &scope : _scopes)
+    {
+        if (scope.contains(name.lexeme))
+            return false;
+    }
+
+    return true;
+}
+
+void lox::Resolver::resolveFunction(const FunctionStatement &function, FunctionType type)
+{
+    const Parallel enclosing = _parallel;
+    ++_parallel.functions;
+    _parallel.loops = 0;
+
+    const FunctionType enclosingFunction = _currentFunction;
+    _currentFunction = type;
+
+    // parameters and the body share one environment at runtime (see LoxFunction::call)
+    beginScope(function._body, function._params);
+    resolve(function._body);
+    endScope();
+
+    _currentFunction = enclosingFunction;
+    _parallel = enclosing;
+}
+
+// ---- parallel loops ----
+
+bool lox::Resolver::isParallelLocal(const Token &name) const
+{
+    for (std::size_t i = _parallel.base; i < _scopes.size(); ++i)
+    {
+        if (_scopes[i].contains(name.lexeme))
+            return true;
+    }
+
+    return false;
+}
+
+bool lox::Resolver::isAccumulator(const Token &name) const
+{
+    return _parallel.reduction && name.lexeme == _parallel.reduction->accumulator.lexeme && !isParallelLocal(name);
+}
+
+void lox::Resolver::checkParallelAssign(const Token &name)
+{
+    if (_parallel.reduction && !isParallelLocal(name) && !isAccumulator(name))
+    {
+        _errors.error(name, "Can't assign to '" + name.lexeme +
+                                "' inside a parallel loop, only accumulate into its reduction.");
+    }
+}
+
+void lox::Resolver::checkParallelChange(const Expression::expr_ptr &object)
+{
+    if (!_parallel.reduction)
+        return;
+
+    // the variable that holds what gets changed: a.b[i].c = ... changes a
+    const Expression *root = object.get();
+    for (;;)
+    {
+        if (const GetExpression *get = dynamic_cast<const GetExpression *>(root))
+            root = get->_object.get();
+        else if (const IndexExpression *index = dynamic_cast<const IndexExpression *>(root))
+            root = index->_object.get();
+        else if (const GroupingExpression *grouping = dynamic_cast<const GroupingExpression *>(root))
+            root = grouping->_expression.get();
+        else
+            break;
+    }
+
+    if (const VarExpression *var = dynamic_cast<const VarExpression *>(root); var && !isParallelLocal(var->_name))
+    {
+        _errors.error(var->_name,
+                      "Can't change '" + var->_name.lexeme + "' inside a parallel loop, it's shared by all iterations.");
+    }
+    else if (const ThisExpression *self = dynamic_cast<const ThisExpression *>(root); self && !_parallel.ownClass)
+        _errors.error(self->_keyword, "Can't change 'this' inside a parallel loop, it's shared by all iterations.");
+}
@@ -0,0 +1,227 @@
+#include "../include/evaluating/Rewriter.h"
+
+void lox::Rewriter::rewrite(const Statement::stmt_vec &stmts)
+{
+    for (const Statement::stmt_ptr &stmt : stmts)
+        rewrite(stmt);
+}
+
+// ----------- rewrite statements ------------
+
+void lox::Rewriter::visitIfStmt(const IfStatement &stmt)
+{
+    rewrite(stmt._condition);
+    rewrite(stmt._thenBranch);
+    rewrite(stmt._elseBranch);
+}
+
+void lox::Rewriter::visitBlockStmt(const BlockStatement &stmt)
+{
+    rewrite(stmt._statements);
+}
+
+void lox::Rewriter::visitClassStmt(const ClassStatement &stmt)
+{
+    for (const ClassStatement::function_ptr &method : stmt._methods)
+        visitFunctionStatement(*method);
+}
+
+void lox::Rewriter::visitExpressionStmt(const ExpressionStatement &stmt)
+{
+    rewrite(stmt._expr);
+}
+
+void lox::Rewriter::visitFunctionStatement(const FunctionStatement &stmt)
+{
+    rewrite(stmt._body);
+}
+
+void lox::Rewriter::visitVarStmt(const VarStatement &stmt)
+{
+    rewrite(stmt._initializer);
+}
+
+void lox::Rewriter::visitPrintStmt(const PrintStatement &stmt)
+{
+    rewrite(stmt._expr);
+}
+
+void lox::Rewriter::visitReturnStmt(const ReturnStatement &stmt)
+{
+    rewrite(stmt._value);
+}
+
+void lox::Rewriter::visitWhileStmt(const WhileStatement &stmt)
+{
+    rewrite(stmt._condition);
+    rewrite(stmt._body);
+}
+
+void lox::Rewriter::visitForStmt(const ForStatement &stmt)
+{
+    rewrite(stmt._initializer);
+    rewrite(stmt._condition);
+    rewrite(stmt._increment);
+    rewrite(stmt._body);
+}
+
+void lox::Rewriter::visitBreakStmt(const BreakStatement &)
+{
+    // EMPTY
+}
+
+// ----------- rewrite expressions ------------
+
+void lox::Rewriter::visitAssignExpr(const AssignExpression &expr)
+{
+    rewrite(expr._value);
+}
+
+void lox::Rewriter::visitBinaryExpr(const BinaryExpression &expr)
+{
+    rewrite(expr._left);
+    rewrite(expr._right);
+}
+
+void lox::Rewriter::visitCallExpr(const CallExpression &expr)
+{
+    rewrite(expr._callee);
+
+    for (const Expression::expr_ptr &arg : expr._args)
+        rewrite(arg);
+}
+
+void lox::Rewriter::visitGetExpr(const GetExpression &expr)
+{
+    rewrite(expr._object);
+}
+
+void lox::Rewriter::visitGroupingExpr(const GroupingExpression &expr)
+{
+    rewrite(expr._expression);
+}
+
+void lox::Rewriter::visitIndexExpr(const IndexExpression &expr)
+{
+    rewrite(expr._object);
+    rewrite(expr._index);
+}
+
+void lox::Rewriter::visitIndexAssignExpr(const IndexAssignExpression &expr)
+{
+    rewrite(expr._object);
+    rewrite(expr._index);
+    rewrite(expr._value);
+}
+
+void lox::Rewriter::visitListExpr(const ListExpression &expr)
+{
+    for (const Expression::expr_ptr &element : expr._elements)
+        rewrite(element);
+}
+
+void lox::Rewriter::visitLiteralExpr(const LiteralExpression &)
+{
+    // EMPTY
+}
+
+void lox::Rewriter::visitLogicalExpr(const LogicalExpression &expr)
+{
+    rewrite(expr._left);
+    rewrite(expr._right);
+}
+
+void lox::Rewriter::visitSetExpr(const SetExpression &expr)
+{
+    rewrite(expr._object);
+    rewrite(expr._value);
+}
+
+void lox::Rewriter::visitSuperExpr(const SuperExpression &)
+{
+    // EMPTY
+}
+
+void lox::Rewriter::visitThisExpr(const ThisExpression &)
+{
+    // EMPTY
+}
+
+void lox::Rewriter::visitUnaryExpr(const UnaryExpression &expr)
+{
+    rewrite(expr._right);
+}
+
+void lox::Rewriter::visitVarExpr(const VarExpression &)
+{
+    // EMPTY
+}
+
+void lox::Rewriter::visitIncrementExpr(const IncrementExpression &)
+{
+    // EMPTY
+}
+
+void lox::Rewriter::visitCompareConstExpr(const CompareConstExpression &)
+{
+    // EMPTY
+}
+
+void lox::Rewriter::visitAssignBinaryExpr(const AssignBinaryExpression &expr)
+{
+    rewrite(expr._right);
+}
+
+void lox::Rewriter::visitLiteralCallExpr(const LiteralCallExpression &)
+{
+    // EMPTY, the arguments are literals already
+}
+
+// ---- protected area -----
+
+void lox::Rewriter::rewrite(const Statement::stmt_ptr &stmt)
+{
+    if (stmt)
+        stmt->accept(*this);
+}
+
+void lox::Rewriter::rewrite(const Expression::expr_ptr &expr)
+{
+    if (!expr)
+        return;
+
+    _current = expr;
+    _replacement = nullptr;
+    expr->accept(*this);
+
+    // the visitors only hand out const nodes, but the slots holding the children aren't const themselves
+    if (_replacement)
+        const_cast<Expression::expr_ptr &>(expr) = std::move(_replacement);
+
+    _replacement = nullptr;
+}
+
+void lox::Rewriter::replaceWith(Expression::expr_ptr replacement)
+{
+    _replacement = std::move(replacement);
+}
+
+bool lox::Rewriter::hasNoSideEffects(const Expression &expr)
+{
+    if (dynamic_cast<const LiteralExpression *>(&expr) || dynamic_cast<const VarExpression *>(&expr))
+        return true;
+    if (const GroupingExpression *grouping = dynamic_cast<const GroupingExpression *>(&expr))
+        return hasNoSideEffects(*grouping->_expression);
+    if (const UnaryExpression *unary = dynamic_cast<const UnaryExpression *>(&expr))
+        return hasNoSideEffects(*unary->_right);
+    if (const BinaryExpression *binary = dynamic_cast<const BinaryExpression *>(&expr))
+        return hasNoSideEffects(*binary->_left) && hasNoSideEffects(*binary->_right);
+    if (const LogicalExpression *logical = dynamic_cast<const LogicalExpression *>(&expr))
+        return hasNoSideEffects(*logical->_left) && hasNoSideEffects(*logical->_right);
+    if (const GetExpression *get = dynamic_cast<const GetExpression *>(&expr))
+        return hasNoSideEffects(*get->_object);
+    if (const IndexExpression *index = dynamic_cast<const IndexExpression *>(&expr))
+        return hasNoSideEffects(*index->_object) && hasNoSideEffects(*index->_index);
+
+    return dynamic_cast<const CompareConstExpression *>(&expr) != nullptr;
+}
@@ -1,6 +1,7 @@
 #include "../include/scanning/Scanner.h"
 #include "../include/ErrorHandler.h"
 #include "../include/types/LoxLiterals.h"
+#include <charconv>
 
 lox::Scanner::tokenlist_t lox::Scanner::scanTokens()
 {
@@ -36,6 +37,12 @@ void lox::Scanner::scanToken()
     case '}':
         addToken(RIGHT_BRACE);
         break;
+    case '[':
+        addToken(LEFT_BRACKET);
+        break;
+    case ']':
+        addToken(RIGHT_BRACKET);
+        break;
     case ',':
         addToken(COMMA);
         break;
@@ -99,7 +106,7 @@ void lox::Scanner::scanToken()
         else if (isAlpha(c))
             identifier();
         else
-            ErrorHandler::error(_line, "Unexcpected character");
+            _errors.error(_line, "Unexcpected character");
     }
 }
 
@@ -122,7 +129,7 @@ void lox::Scanner::string()
 
     if (isAtEnd())
     {
-        ErrorHandler::error(_line, "Unterminated string.");
+        _errors.error(_line, "Unterminated string.");
         return;
     }
 
@@ -140,16 +147,32 @@ void lox::Scanner::number()
         advance();
 
     // optional fractional part
+    bool isIntegral = true;
     if (peek() == '.' && std::isdigit(peekNext()))
     {
         // consume the "."
         advance();
+        isIntegral = false;
 
         while (std::isdigit(peek()))
             advance();
     }
 
     const auto str_value = _source.substr(_start, _current - _start);
+
+    // integral literals are kept as ints, unless they are too large for one
+    std::int64_t integer;
+    if (isIntegral)
+    {
+        const char *end = str_value.data() + str_value.size();
+        const auto [ptr, ec] = std::from_chars(str_value.data(), end, integer);
+        if (ec == std::errc{} && ptr == end)
+        {
+            addToken(TokenType::NUMBER, integer);
+            return;
+        }
+    }
+
     addToken(TokenType::NUMBER, std::stod(str_value));
 }
 
@@ -186,7 +209,7 @@ void lox::Scanner::multiline_comment()
     {
         if (isAtEnd())
         {
-            ErrorHandler::error(_line, "block-comment not closed.");
+            _errors.error(_line, "block-comment not closed.");
             return;
         }
 
@@ -0,0 +1,344 @@
+#include "../include/Server.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <streambuf>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // SIGPIPE is ignored anyway
+#endif
+#endif
+
+#ifdef _WIN32
+
+int lox::Server::serve()
+{
+    std::cerr << "--serve needs unix domain sockets, it isn't supported on this platform" << std::endl;
+    return EXIT_FAILURE;
+}
+
+int lox::Server::submit(const std::string &, const std::string &)
+{
+    std::cerr << "--submit needs unix domain sockets, it isn't supported on this platform" << std::endl;
+    return EXIT_FAILURE;
+}
+
+#else
+
+namespace
+{
+constexpr char stdoutFrame = 'o';
+constexpr char stderrFrame = 'e';
+constexpr char exitFrame = 'x';
+
+bool writeAll(int fd, const char *data, std::size_t size)
+{
+    while (size > 0)
+    {
+        const ssize_t written = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false; // the client is gone, the script still runs to the end
+        }
+
+        data += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+bool readAll(int fd, char *data, std::size_t size)
+{
+    while (size > 0)
+    {
+        const ssize_t received = ::recv(fd, data, size, 0);
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received <= 0)
+            return false;
+
+        data += received;
+        size -= received;
+    }
+
+    return true;
+}
+
+bool writeFrame(int fd, char kind, const char *data, std::uint32_t size)
+{
+    char header[1 + sizeof(size)];
+    header[0] = kind;
+    std::memcpy(header + 1, &size, sizeof(size));
+
+    return writeAll(fd, header, sizeof(header)) && writeAll(fd, data, size);
+}
+
+// sends everything written to it as frames of one kind
+class FrameBuffer : public std::streambuf
+{
+  public:
+    FrameBuffer(int fd, char kind) : _fd{fd}, _kind{kind}
+    {
+        setp(_buffer, _buffer + sizeof(_buffer));
+    }
+
+    ~FrameBuffer() override
+    {
+        sync();
+    }
+
+  protected:
+    int_type overflow(int_type c) override
+    {
+        if (sync() != 0)
+            return traits_type::eof();
+
+        if (!traits_type::eq_int_type(c, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+
+        return traits_type::not_eof(c);
+    }
+
+    int sync() override
+    {
+        const std::size_t size = pptr() - pbase();
+        setp(_buffer, _buffer + sizeof(_buffer));
+
+        return size == 0 || writeFrame(_fd, _kind, _buffer, size) ? 0 : -1;
+    }
+
+  private:
+    const int _fd;
+    const char _kind;
+    char _buffer[4096];
+};
+
+// swaps the buffer of a standard stream while it's alive
+class Redirect
+{
+  public:
+    Redirect(std::ostream &stream, std::streambuf *buffer) : _stream{stream}, _previous{stream.rdbuf(buffer)}
+    {
+    }
+
+    ~Redirect()
+    {
+        _stream.flush();
+        _stream.rdbuf(_previous);
+    }
+
+  private:
+    std::ostream &_stream;
+    std::streambuf *const _previous;
+};
+
+std::optional<std::string> readSource(int fd)
+{
+    std::uint32_t size;
+    if (!readAll(fd, reinterpret_cast<char *>(&size), sizeof(size)))
+        return std::nullopt;
+
+    std::string sourceCode(size, '\0');
+    if (!readAll(fd, sourceCode.data(), size))
+        return std::nullopt;
+
+    return sourceCode;
+}
+
+std::optional<sockaddr_un> socketAddress(const std::string &path)
+{
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "Socket path is too long: " << path << std::endl;
+        return std::nullopt;
+    }
+
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+} // namespace
+
+int lox::Server::serve()
+{
+    std::signal(SIGPIPE, SIG_IGN);
+    if (_options.fork)
+        std::signal(SIGCHLD, SIG_IGN); // the children are reaped automatically
+
+    // the prelude runs like a normal script (errors end the server), its definitions are in every fresh scope
+    if (!_options.prelude.empty() && !_lox.runFile(std::string{_options.prelude}))
+        return EXIT_FAILURE;
+
+    _lox.snapshotGlobals();
+
+    const std::optional<sockaddr_un> address = socketAddress(_options.socketPath);
+    if (!address)
+        return EXIT_FAILURE;
+
+    const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+    {
+        std::perror("socket");
+        return EXIT_FAILURE;
+    }
+
+    ::unlink(_options.socketPath.c_str()); // left over from an earlier server
+    if (::bind(listener, reinterpret_cast<const sockaddr *>(&*address), sizeof(*address)) != 0 ||
+        ::listen(listener, SOMAXCONN) != 0)
+    {
+        std::perror(_options.socketPath.c_str());
+        ::close(listener);
+        return EXIT_FAILURE;
+    }
+
+    std::cerr << "serving on " << _options.socketPath << (_options.fork ? " (fork per script)" : "") << std::endl;
+
+    while (true)
+    {
+        const int connection = ::accept(listener, nullptr, nullptr);
+        if (connection < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+
+            std::perror("accept");
+            ::close(listener);
+            return EXIT_FAILURE;
+        }
+
+        if (!_options.fork)
+        {
+            handle(connection);
+            continue;
+        }
+
+        std::cout.flush();
+        std::cerr.flush();
+
+        const pid_t child = ::fork();
+        if (child == 0)
+        {
+            ::close(listener);
+            handle(connection);
+            std::_Exit(EXIT_SUCCESS); // skips the destructors, the process is gone anyway
+        }
+
+        if (child < 0)
+        {
+            std::perror("fork");
+            handle(connection); // run it in the server then
+        }
+        else
+            ::close(connection);
+    }
+}
+
+int lox::Server::submit(const std::string &socketPath, const std::string &script)
+{
+    std::ifstream file{script, std::ios::binary};
+    if (!file)
+    {
+        std::cerr << "Failed to open file!" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::string sourceCode{std::istreambuf_iterator<char>{file}, {}};
+
+    const std::optional<sockaddr_un> address = socketAddress(socketPath);
+    if (!address)
+        return EXIT_FAILURE;
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<const sockaddr *>(&*address), sizeof(*address)) != 0)
+    {
+        std::perror(socketPath.c_str());
+        return EXIT_FAILURE;
+    }
+
+    const std::uint32_t size = sourceCode.size();
+    if (!writeAll(fd, reinterpret_cast<const char *>(&size), sizeof(size)) ||
+        !writeAll(fd, sourceCode.data(), size))
+    {
+        std::perror(socketPath.c_str());
+        ::close(fd);
+        return EXIT_FAILURE;
+    }
+
+    char header[1 + sizeof(std::uint32_t)];
+    std::string payload;
+    while (readAll(fd, header, sizeof(header)))
+    {
+        std::uint32_t length;
+        std::memcpy(&length, header + 1, sizeof(length));
+
+        payload.resize(length);
+        if (!readAll(fd, payload.data(), length))
+            break;
+
+        switch (header[0])
+        {
+        case stdoutFrame:
+            std::cout.write(payload.data(), length);
+            break;
+        case stderrFrame:
+            std::cerr.write(payload.data(), length);
+            break;
+        case exitFrame: {
+            std::int32_t status = EXIT_FAILURE;
+            std::memcpy(&status, payload.data(), std::min<std::size_t>(length, sizeof(status)));
+            ::close(fd);
+            return status;
+        }
+        }
+    }
+
+    ::close(fd);
+    std::cerr << "The server closed the connection before the script finished." << std::endl;
+    return EXIT_FAILURE;
+}
+
+// ---- private area -----
+
+void lox::Server::handle(int connection)
+{
+    if (const std::optional<std::string> sourceCode = readSource(connection))
+    {
+        const std::int32_t status = runScript(connection, *sourceCode);
+        writeFrame(connection, exitFrame, reinterpret_cast<const char *>(&status), sizeof(status));
+    }
+
+    ::close(connection);
+}
+
+int lox::Server::runScript(int connection, const std::string &sourceCode)
+{
+    FrameBuffer out{connection, stdoutFrame};
+    FrameBuffer err{connection, stderrFrame};
+    const Redirect redirectOut{std::cout, &out};
+    const Redirect redirectErr{std::cerr, &err};
+
+    _lox.resetErrors();
+
+    _lox.restoreGlobals();
+    _lox.run(sourceCode);
+
+    return _lox.hadError() || _lox.hadRuntimeError() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#endif
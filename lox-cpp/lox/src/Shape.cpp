@@ -0,0 +1,52 @@
+#include "../include/types/Shape.h"
+#include "../include/scanning/Token.h"
+#include <atomic>
+
+namespace
+{
+std::uint32_t nextShapeId()
+{
+    static std::atomic<std::uint32_t> counter = 0;
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1; // 0 is reserved for empty cache entries
+}
+} // namespace
+
+lox::Shape::Shape() : _id{nextShapeId()}
+{
+}
+
+std::uint32_t lox::Shape::slotOf(const Token &name) const
+{
+    if (_fields.size() > linearScanLimit)
+        return _index.find(name.hash, [&](std::uint32_t slot) { return _fields[slot].name == name.lexeme; });
+
+    for (std::uint32_t i = 0; i < _fields.size(); ++i)
+    {
+        if (_fields[i].hash == name.hash && _fields[i].name == name.lexeme)
+            return i;
+    }
+
+    return HashIndex::npos;
+}
+
+lox::Shape::shape_ptr lox::Shape::withField(const Token &name)
+{
+    for (const Transition &transition : _transitions)
+    {
+        if (transition.hash == name.hash && transition.name == name.lexeme)
+            return transition.shape;
+    }
+
+    shape_ptr shape = std::make_shared<Shape>();
+    shape->_fields = _fields;
+    shape->_fields.push_back(Field{name.hash, name.lexeme});
+
+    if (shape->_fields.size() > linearScanLimit)
+    {
+        for (std::uint32_t i = 0; i < shape->_fields.size(); ++i)
+            shape->_index.insert(shape->_fields[i].hash, i);
+    }
+
+    _transitions.push_back(Transition{name.hash, name.lexeme, shape});
+    return shape;
+}
@@ -0,0 +1,153 @@
+#include "../include/ThreadPool.h"
+#include <algorithm>
+
+namespace
+{
+// the pool and queue of the worker running on this thread, submits from a worker stay local
+thread_local const lox::ThreadPool *currentPool = nullptr;
+thread_local std::size_t currentIndex = 0;
+} // namespace
+
+lox::ThreadPool::ThreadPool(std::size_t threads)
+    : _size{threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())}, _running{_size}
+{
+    for (std::size_t i = 0; i < _size; ++i)
+        _queues.push_back(std::make_unique<Queue>());
+
+    for (std::size_t i = 0; i < _size; ++i)
+        _workers.emplace_back(&ThreadPool::work, this, i);
+}
+
+lox::ThreadPool::~ThreadPool()
+{
+    std::unique_lock lock{_mutex};
+    _stopping = true;
+    _wake.notify_all();
+    lock.unlock();
+
+    for (std::thread &worker : _workers)
+        worker.join();
+
+    // the spares are detached, they are gone once they say so
+    lock.lock();
+    _sparesDone.wait(lock, [this] { return _spares == 0; });
+}
+
+void lox::ThreadPool::submit(task_t task)
+{
+    const std::size_t index = ::currentPool == this && currentIndex != spare
+                                  ? currentIndex
+                                  : _next.fetch_add(1, std::memory_order_relaxed) % _queues.size();
+
+    {
+        const std::lock_guard lock{_queues[index]->mutex};
+        _queues[index]->tasks.push_back(std::move(task));
+        ++_queued; // with the task, so it never drops below the tasks in the queues
+    }
+
+    // a worker that just found nothing holds the lock until it sleeps, it can't miss the wake up
+    {
+        const std::lock_guard lock{_mutex};
+    }
+    _wake.notify_one();
+}
+
+bool lox::ThreadPool::runPending()
+{
+    task_t task;
+    if (!take(::currentPool == this ? currentIndex : spare, task))
+        return false;
+
+    task();
+    return true;
+}
+
+// ---- private area -----
+
+const lox::ThreadPool *lox::ThreadPool::currentPool()
+{
+    return ::currentPool;
+}
+
+void lox::ThreadPool::work(std::size_t index)
+{
+    ::currentPool = this;
+    currentIndex = index;
+
+    while (true)
+    {
+        task_t task;
+        if (take(index, task))
+        {
+            task();
+            continue;
+        }
+
+        std::unique_lock lock{_mutex};
+        const bool surplus = index == spare && _running > _size; // the blocked worker is back
+        if (surplus || (_stopping && _queued == 0))
+        {
+            if (index == spare)
+            {
+                --_running;
+                --_spares;
+                _sparesDone.notify_all();
+            }
+            return;
+        }
+
+        _wake.wait(lock, [&] {
+            return _queued > 0 || _stopping || (index == spare && _running > _size);
+        });
+    }
+}
+
+bool lox::ThreadPool::take(std::size_t index, task_t &task)
+{
+    if (index != spare)
+    {
+        Queue &own = *_queues[index];
+        const std::lock_guard lock{own.mutex};
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            --_queued;
+            return true;
+        }
+    }
+
+    const std::size_t first = index != spare ? index + 1 : 0;
+    for (std::size_t i = 0; i < _queues.size(); ++i)
+    {
+        Queue &victim = *_queues[(first + i) % _queues.size()];
+        const std::lock_guard lock{victim.mutex};
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            --_queued;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void lox::ThreadPool::enterBlocking()
+{
+    const std::lock_guard lock{_mutex};
+    if (--_running >= _size || _stopping)
+        return; // an idle spare takes over
+
+    ++_running;
+    ++_spares;
+    std::thread{&ThreadPool::work, this, spare}.detach();
+}
+
+void lox::ThreadPool::leaveBlocking()
+{
+    const std::lock_guard lock{_mutex};
+    if (++_running > _size)
+        _wake.notify_all(); // one spare too many now
+}
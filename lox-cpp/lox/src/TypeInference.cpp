@@ -0,0 +1,457 @@
+#include "../include/evaluating/TypeInference.h"
+#include <algorithm>
+
+void lox::TypeInference::infer(const Statement::stmt_vec &stmts)
+{
+    // the first run finds the names that functions assign behind the pass' back, the second one marks the nodes
+    for (const bool collecting : {true, false})
+    {
+        _collecting = collecting;
+        _scopes.assign(1, {}); // the top level
+        _functionBase = 0;
+        _nextId = 0;
+        _state.clear();
+        _dead = false;
+        _checks.clear();
+
+        analyze(stmts);
+    }
+}
+
+std::size_t lox::TypeInference::removedChecks() const
+{
+    return std::count_if(_checks.begin(), _checks.end(), [](const auto &check) { return check.second; });
+}
+
+// ----------- analyze statements ------------
+
+void lox::TypeInference::visitIfStmt(const IfStatement &stmt)
+{
+    infer(stmt._condition);
+
+    const state_t before = _state;
+    const bool beforeDead = _dead;
+    analyze(stmt._thenBranch);
+    const state_t afterThen = std::move(_state);
+    const bool thenDead = _dead;
+
+    _state = before;
+    _dead = beforeDead;
+    analyze(stmt._elseBranch);
+    merge(afterThen, thenDead);
+}
+
+void lox::TypeInference::visitBlockStmt(const BlockStatement &stmt)
+{
+    _scopes.emplace_back();
+    analyze(stmt._statements);
+    _scopes.pop_back();
+}
+
+void lox::TypeInference::visitClassStmt(const ClassStatement &stmt)
+{
+    declare(stmt._name, StaticType::UNKNOWN);
+
+    if (stmt._superclass)
+        stmt._superclass->accept(*this);
+
+    for (const ClassStatement::function_ptr &method : stmt._methods)
+        analyzeFunction(*method);
+}
+
+void lox::TypeInference::visitExpressionStmt(const ExpressionStatement &stmt)
+{
+    infer(stmt._expr);
+}
+
+void lox::TypeInference::visitFunctionStatement(const FunctionStatement &stmt)
+{
+    // a lazy body isn't parsed yet, assume it assigns every name that could be assigned in it
+    if (_collecting && stmt._lazy)
+        _escapedNames.insert(stmt._lazy->assigned.begin(), stmt._lazy->assigned.end());
+
+    declare(stmt._name, StaticType::UNKNOWN);
+    analyzeFunction(stmt);
+}
+
+void lox::TypeInference::visitVarStmt(const VarStatement &stmt)
+{
+    const StaticType type = stmt._initializer ? infer(stmt._initializer) : StaticType::NIL;
+    declare(stmt._name, type);
+}
+
+void lox::TypeInference::visitPrintStmt(const PrintStatement &stmt)
+{
+    infer(stmt._expr);
+}
+
+void lox::TypeInference::visitReturnStmt(const ReturnStatement &stmt)
+{
+    infer(stmt._value);
+    _dead = true;
+}
+
+void lox::TypeInference::visitWhileStmt(const WhileStatement &stmt)
+{
+    analyzeLoop(stmt._condition, stmt._body, nullptr);
+}
+
+void lox::TypeInference::visitForStmt(const ForStatement &stmt)
+{
+    _scopes.emplace_back(); // the counter's scope
+    analyze(stmt._initializer);
+    analyzeLoop(stmt._condition, stmt._body, stmt._increment);
+    _scopes.pop_back();
+}
+
+void lox::TypeInference::visitBreakStmt(const BreakStatement &)
+{
+    if (!_breakStates.empty() && !_dead)
+        _breakStates.back().push_back(_state);
+
+    _dead = true;
+}
+
+// ----------- infer expressions ------------
+
+void lox::TypeInference::visitAssignExpr(const AssignExpression &expr)
+{
+    const StaticType type = infer(expr._value);
+
+    if (_collecting && _functionBase > 0 && findLocal(expr._name) == npos)
+        _escapedNames.insert(expr._name.lexeme);
+
+    assign(expr._name, type);
+    _type = type;
+}
+
+void lox::TypeInference::visitBinaryExpr(const BinaryExpression &expr)
+{
+    const StaticType left = infer(expr._left);
+    const StaticType right = infer(expr._right);
+    _type = binaryType(expr, expr._unchecked, expr._operator.type, left, right);
+}
+
+void lox::TypeInference::visitCallExpr(const CallExpression &expr)
+{
+    infer(expr._callee);
+
+    for (const Expression::expr_ptr &arg : expr._args)
+        infer(arg);
+
+    _type = StaticType::UNKNOWN;
+}
+
+void lox::TypeInference::visitGetExpr(const GetExpression &expr)
+{
+    infer(expr._object);
+    _type = StaticType::UNKNOWN;
+}
+
+void lox::TypeInference::visitGroupingExpr(const GroupingExpression &expr)
+{
+    _type = infer(expr._expression);
+}
+
+void lox::TypeInference::visitIndexExpr(const IndexExpression &expr)
+{
+    infer(expr._object);
+    infer(expr._index);
+    _type = StaticType::UNKNOWN;
+}
+
+void lox::TypeInference::visitIndexAssignExpr(const IndexAssignExpression &expr)
+{
+    infer(expr._object);
+    infer(expr._index);
+    _type = infer(expr._value);
+}
+
+void lox::TypeInference::visitListExpr(const ListExpression &expr)
+{
+    for (const Expression::expr_ptr &element : expr._elements)
+        infer(element);
+
+    _type = StaticType::UNKNOWN;
+}
+
+void lox::TypeInference::visitLiteralExpr(const LiteralExpression &expr)
+{
+    _type = typeOf(expr._value);
+}
+
+void lox::TypeInference::visitLogicalExpr(const LogicalExpression &expr)
+{
+    const StaticType left = infer(expr._left);
+    const state_t afterLeft = _state;
+
+    // the right operand might not be evaluated at all
+    const StaticType right = infer(expr._right);
+    merge(afterLeft, _dead);
+    _type = join(left, right);
+}
+
+void lox::TypeInference::visitSetExpr(const SetExpression &expr)
+{
+    infer(expr._object);
+    _type = infer(expr._value);
+}
+
+void lox::TypeInference::visitSuperExpr(const SuperExpression &)
+{
+    _type = StaticType::UNKNOWN;
+}
+
+void lox::TypeInference::visitThisExpr(const ThisExpression &)
+{
+    _type = StaticType::UNKNOWN;
+}
+
+void lox::TypeInference::visitUnaryExpr(const UnaryExpression &expr)
+{
+    const StaticType right = infer(expr._right);
+
+    if (expr._operator.type == TokenType::MINUS)
+    {
+        markChecked(expr, expr._unchecked, right == StaticType::NUMBER);
+        _type = StaticType::NUMBER;
+    }
+    else
+        _type = StaticType::BOOL;
+}
+
+void lox::TypeInference::visitVarExpr(const VarExpression &expr)
+{
+    _type = lookup(expr._name);
+}
+
+void lox::TypeInference::visitIncrementExpr(const IncrementExpression &expr)
+{
+    _type = binaryType(expr, expr._unchecked, expr._operator.type, lookup(expr._name), StaticType::NUMBER);
+    assign(expr._name, _type);
+}
+
+void lox::TypeInference::visitCompareConstExpr(const CompareConstExpression &expr)
+{
+    _type = binaryType(expr, expr._unchecked, expr._operator.type, lookup(expr._name), typeOf(expr._constant));
+}
+
+void lox::TypeInference::visitAssignBinaryExpr(const AssignBinaryExpression &expr)
+{
+    const StaticType left = lookup(expr._name); // the right operand has no side effects
+    const StaticType right = infer(expr._right);
+
+    _type = binaryType(expr, expr._unchecked, expr._operator.type, left, right);
+    assign(expr._name, _type);
+}
+
+void lox::TypeInference::visitLiteralCallExpr(const LiteralCallExpression &expr)
+{
+    infer(expr._call);
+}
+
+// ---- private area -----
+
+lox::TypeInference::StaticType lox::TypeInference::typeOf(const literal_t &value)
+{
+    using namespace std;
+
+    if (holds_alternative<nullptr_t>(value))
+        return StaticType::NIL;
+    if (holds_alternative<bool>(value))
+        return StaticType::BOOL;
+    if (holds_alternative<double>(value) || holds_alternative<int64_t>(value))
+        return StaticType::NUMBER;
+    if (holds_alternative<string>(value))
+        return StaticType::STRING;
+
+    return StaticType::UNKNOWN;
+}
+
+lox::TypeInference::StaticType lox::TypeInference::binaryType(const Expression &expr, bool &unchecked, TokenType op,
+                                                              StaticType left, StaticType right)
+{
+    const bool numbers = left == StaticType::NUMBER && right == StaticType::NUMBER;
+
+    using enum TokenType;
+
+    switch (op)
+    {
+    case GREATER:
+    case GREATER_EQUAL:
+    case LESS:
+    case LESS_EQUAL:
+        markChecked(expr, unchecked, numbers);
+        return StaticType::BOOL;
+    case MINUS:
+    case SLASH:
+    case STAR:
+        markChecked(expr, unchecked, numbers);
+        return StaticType::NUMBER; // otherwise the check throws
+    case PLUS:
+        markChecked(expr, unchecked, numbers);
+        if (numbers)
+            return StaticType::NUMBER;
+        if (left == StaticType::STRING || right == StaticType::STRING)
+            return StaticType::STRING;
+        return StaticType::UNKNOWN;
+    default: // == and !=
+        return StaticType::BOOL;
+    }
+}
+
+lox::TypeInference::StaticType lox::TypeInference::join(StaticType a, StaticType b)
+{
+    return a == b ? a : StaticType::UNKNOWN;
+}
+
+lox::TypeInference::state_t lox::TypeInference::join(const state_t &a, const state_t &b)
+{
+    // variables only one side knows about went out of scope already
+    state_t result = a.size() >= b.size() ? a : b;
+    const std::size_t n = std::min(a.size(), b.size());
+    for (std::size_t i = 0; i < n; ++i)
+        result[i] = join(a[i], b[i]);
+
+    return result;
+}
+
+void lox::TypeInference::merge(const state_t &other, bool otherDead)
+{
+    if (_dead)
+    {
+        _state = other;
+        _dead = otherDead;
+    }
+    else if (!otherDead)
+        _state = join(_state, other);
+}
+
+void lox::TypeInference::analyze(const Statement::stmt_vec &stmts)
+{
+    for (const Statement::stmt_ptr &stmt : stmts)
+        analyze(stmt);
+}
+
+void lox::TypeInference::analyze(const Statement::stmt_ptr &stmt)
+{
+    if (stmt)
+        stmt->accept(*this);
+}
+
+lox::TypeInference::StaticType lox::TypeInference::infer(const Expression::expr_ptr &expr)
+{
+    _type = StaticType::UNKNOWN;
+    if (expr)
+        expr->accept(*this);
+
+    return _type;
+}
+
+void lox::TypeInference::analyzeLoop(const Expression::expr_ptr &condition, const Statement::stmt_ptr &body,
+                                      const Expression::expr_ptr &increment)
+{
+    // variables declared in the body get the same ids in every iteration
+    const std::size_t live = _nextId;
+    const bool wasDead = _dead;
+
+    // iterate until the state at the loop head doesn't change anymore, types only ever get less precise
+    for (;;)
+    {
+        const state_t head = _state;
+        _nextId = live;
+
+        infer(condition);
+        state_t exit = _state;
+
+        _breakStates.emplace_back();
+        analyze(body);
+        infer(increment);
+        const std::vector<state_t> breaks = std::move(_breakStates.back());
+        _breakStates.pop_back();
+
+        // the body only loops back if its end is reachable
+        state_t next = _dead ? head : join(head, _state);
+        const std::size_t n = std::min(live, head.size());
+        if (std::equal(head.begin(), head.begin() + n, next.begin()))
+        {
+            for (const state_t &state : breaks)
+                exit = join(exit, state);
+
+            _state = std::move(exit);
+            _dead = wasDead;
+            return;
+        }
+
+        _state = std::move(next);
+        _dead = wasDead;
+    }
+}
+
+void lox::TypeInference::analyzeFunction(const FunctionStatement &stmt)
+{
+    const std::size_t enclosingBase = _functionBase;
+    const bool enclosingDead = _dead;
+    std::vector<std::vector<state_t>> enclosingBreaks = std::move(_breakStates);
+    _breakStates.clear();
+
+    // parameters and the body share one scope, there is no telling what the arguments are
+    _functionBase = _scopes.size();
+    _scopes.emplace_back();
+    for (const Token &param : stmt._params)
+        declare(param, StaticType::UNKNOWN);
+
+    analyze(stmt._body);
+
+    _scopes.pop_back();
+    _functionBase = enclosingBase;
+    _dead = enclosingDead;
+    _breakStates = std::move(enclosingBreaks);
+}
+
+void lox::TypeInference::declare(const Token &name, StaticType type)
+{
+    const std::size_t id = _nextId++;
+    _scopes.back()[name.lexeme] = id;
+
+    if (_state.size() <= id)
+        _state.resize(id + 1, StaticType::UNKNOWN);
+    _state[id] = type;
+}
+
+void lox::TypeInference::assign(const Token &name, StaticType type)
+{
+    const std::size_t id = findLocal(name);
+    if (id != npos)
+        _state[id] = type;
+}
+
+lox::TypeInference::StaticType lox::TypeInference::lookup(const Token &name) const
+{
+    const std::size_t id = findLocal(name);
+    if (id == npos || _escapedNames.contains(name.lexeme))
+        return StaticType::UNKNOWN;
+
+    return _state[id];
+}
+
+std::size_t lox::TypeInference::findLocal(const Token &name) const
+{
+    // the top level scope holds the globals
+    const std::size_t first = _trackGlobals ? _functionBase : std::max<std::size_t>(_functionBase, 1);
+    for (std::size_t i = _scopes.size(); i-- > first;)
+    {
+        const auto it = _scopes[i].find(name.lexeme);
+        if (it != _scopes[i].end())
+            return it->second;
+    }
+
+    return npos;
+}
+
+void lox::TypeInference::markChecked(const Expression &expr, bool &unchecked, bool proven)
+{
+    unchecked = proven;
+    if (!_collecting)
+        _checks[&expr] = proven;
+}
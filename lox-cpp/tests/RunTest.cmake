@@ -0,0 +1,47 @@
+# runs the interpreter on one test: <name>.lox is the script, <name>.in its input (or what is typed into the
+# prompt, if there is no script).
+# <name>.args holds options that go before the script, ${TESTS} in them (and in the expected output and errors)
+# is the directory of the tests.
+# the output has to be <name>.out, the errors <name>.err (nothing, if there is no such file)
+# cmake -DLOX=<interpreter> -DTEST=<directory>/<name> -P RunTest.cmake
+
+set(command ${LOX})
+if(EXISTS ${TEST}.args)
+    get_filename_component(TESTS ${TEST} DIRECTORY)
+    file(READ ${TEST}.args args)
+    string(CONFIGURE "${args}" args)
+    separate_arguments(args UNIX_COMMAND "${args}")
+    list(APPEND command ${args})
+endif()
+
+if(EXISTS ${TEST}.lox)
+    list(APPEND command ${TEST}.lox)
+endif()
+
+set(input "")
+if(EXISTS ${TEST}.in)
+    set(input INPUT_FILE ${TEST}.in)
+endif()
+
+execute_process(COMMAND ${command} ${input} OUTPUT_VARIABLE out ERROR_VARIABLE err RESULT_VARIABLE result)
+
+if(NOT result MATCHES "^[0-9]+$")
+    message(FATAL_ERROR "the interpreter crashed: ${result}\n${err}")
+endif()
+
+file(READ ${TEST}.out expectedOut)
+set(expectedErr "")
+if(EXISTS ${TEST}.err)
+    file(READ ${TEST}.err expectedErr)
+endif()
+if(EXISTS ${TEST}.args)
+    string(CONFIGURE "${expectedOut}" expectedOut)
+    string(CONFIGURE "${expectedErr}" expectedErr)
+endif()
+
+if(NOT out STREQUAL expectedOut)
+    message(FATAL_ERROR "output:\n${out}\nexpected:\n${expectedOut}")
+endif()
+if(NOT err STREQUAL expectedErr)
+    message(FATAL_ERROR "errors:\n${err}\nexpected:\n${expectedErr}")
+endif()
@@ -0,0 +1,82 @@
+// runs a script with --cache a few times: the first run compiles and stores it, the next ones load it. a cache
+// file that is corrupt or belongs to other source code is ignored and written again
+
+#include "../../lox/include/Lox.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+const std::string script = "ast_cache.lox";
+const std::string cache = "ast_cache.loxc"; // next to the script
+
+void write(const std::string &path, const std::string &text)
+{
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    file << text;
+}
+
+// prints hit or miss and the output of the script, the times of the report differ from run to run
+void run(const std::string &label)
+{
+    lox::Lox::Options options;
+    options.cache = true;
+    options.report = true;
+
+    std::ostringstream out;
+    std::ostringstream err;
+    lox::Lox lox{options, out, err};
+    const bool success = lox.runFile(std::string{script});
+
+    const std::string report = err.str();
+    const char *const result = report.find("ast cache: hit") != std::string::npos    ? "hit"
+                               : report.find("ast cache: miss") != std::string::npos ? "miss"
+                                                                                     : "no cache";
+
+    std::cout << label << ": " << result << (success ? "" : ", failed") << "\n" << out.str();
+}
+} // namespace
+
+int main()
+{
+    std::filesystem::remove(cache);
+
+    write(script, "fun square(x) { return x * x; }\n"
+                  "class Pair { init(a, b) { this.a = a; this.b = b; } }\n"
+                  "var p = Pair(3, \"s\");\n"
+                  "for (var i = 0; i < 3; i = i + 1) print square(i) + p.a;\n"
+                  "print p.b;\n");
+    run("first run");
+    run("second run");
+
+    // half of the file is gone
+    std::filesystem::resize_file(cache, std::filesystem::file_size(cache) / 2);
+    run("truncated");
+    run("after truncated");
+
+    // the header is fine, the nodes are garbage
+    std::string bytes;
+    {
+        std::ifstream file{cache, std::ios::binary};
+        std::stringstream contents;
+        contents << file.rdbuf();
+        bytes = contents.str();
+    }
+    for (std::size_t i = bytes.size() / 3; i < bytes.size(); ++i)
+        bytes[i] = static_cast<char>(0xff - i % 7);
+    write(cache, bytes);
+    run("corrupt");
+    run("after corrupt");
+
+    // changed source, the cache is for the old one
+    write(script, "print \"changed\";\n");
+    run("changed source");
+    run("after changed source");
+
+    std::filesystem::remove(cache);
+    std::filesystem::remove(script);
+}
@@ -0,0 +1,86 @@
+// prepares a program once and executes it on several isolates, one per thread: its inputs are globals defined
+// before it runs, its results are globals read afterwards
+
+#include "../../lox/include/Lox.h"
+
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+namespace
+{
+const std::string source = "fun square(x) { return x * x; }\n"
+                           "var result = square(input);\n"
+                           "if (input < 0) print undefined;\n";
+
+std::string describe(const std::optional<lox::literal_t> &value)
+{
+    if (!value)
+        return "not defined";
+    if (const std::int64_t *number = std::get_if<std::int64_t>(&*value))
+        return std::to_string(*number);
+    return "not an int";
+}
+} // namespace
+
+int main()
+{
+    std::cout << std::boolalpha;
+
+    std::ostringstream out;
+    std::ostringstream err;
+    lox::Lox lox{lox::Lox::Options{}, out, err};
+
+    const std::shared_ptr<const lox::Program> program = lox.prepare(source);
+    std::cout << "prepared: " << (program != nullptr) << "\n";
+
+    // the same isolate, one execution after another
+    for (const std::int64_t input : {3, 4})
+    {
+        lox.define("input", input);
+        const bool success = lox.execute(program);
+        std::cout << "input " << input << ": " << success << ", result " << describe(lox.global("result")) << "\n";
+    }
+    std::cout << "missing: " << describe(lox.global("missing")) << "\n";
+
+    // a runtime error fails the execution, the isolate and the program can be used again
+    lox.define("input", std::int64_t{-2});
+    std::cout << "input -2: " << lox.execute(program) << "\n" << err.str();
+    lox.define("input", std::int64_t{5});
+    std::cout << "input 5: " << lox.execute(program) << ", result " << describe(lox.global("result")) << "\n";
+
+    // an isolate per thread, all of them on the copies of the one program
+    constexpr std::int64_t threads = 4;
+    constexpr std::int64_t executions = 200;
+    std::vector<std::int64_t> failures(threads, 0);
+    std::vector<std::thread> workers;
+    for (std::int64_t t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t] {
+            lox::Lox isolate;
+            for (std::int64_t i = 0; i < executions; ++i)
+            {
+                const std::int64_t input = t * executions + i;
+                isolate.define("input", input);
+                const std::optional<lox::literal_t> result =
+                    isolate.execute(program) ? isolate.global("result") : std::nullopt;
+                if (!result || describe(result) != std::to_string(input * input))
+                    ++failures[t];
+            }
+        });
+    }
+    for (std::thread &worker : workers)
+        worker.join();
+    for (std::int64_t t = 0; t < threads; ++t)
+        std::cout << "thread " << t << ": " << failures[t] << " failures\n";
+
+    // a program with errors isn't prepared
+    std::ostringstream prepareErr;
+    lox::Lox other{lox::Lox::Options{}, out, prepareErr};
+    std::cout << "broken: " << (other.prepare("var = 1;") != nullptr) << "\n" << prepareErr.str();
+}
@@ -0,0 +1,110 @@
+// submits scripts to a server (--serve) with a prelude, in both modes. every script starts with the globals of the
+// prelude as they were after it ran, whatever the scripts before changed
+
+#include "../../lox/include/Lox.h"
+#include "../../lox/include/Server.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+void write(const std::string &path, const std::string &text)
+{
+    std::ofstream file{path, std::ios::trunc};
+    file << text;
+}
+
+// until the server accepts connections, the one made here is closed right away (an empty script)
+bool waitForServer(const std::string &socketPath)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    socketPath.copy(address.sun_path, sizeof(address.sun_path) - 1);
+
+    for (int attempt = 0; attempt < 500; ++attempt)
+    {
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        const bool connected = ::connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0;
+        ::close(fd);
+        if (connected)
+            return true;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    return false;
+}
+
+void submit(const std::string &socketPath, const std::string &script)
+{
+    std::cout << "-- " << script << std::endl;
+    const int status = lox::Server::submit(socketPath, script);
+    std::cout << "exit " << status << std::endl;
+}
+} // namespace
+
+int main()
+{
+    write("server_prelude.lox", "var counter = 0;\n"
+                                "fun bump() { counter = counter + 1; return counter; }\n"
+                                "var shared = [1];\n"
+                                "class Box { init(v) { this.v = v; this.self = this; } }\n"
+                                "var box = Box(1);\n"
+                                "var m = map();\n"
+                                "set(m, \"box\", box);\n");
+    write("server_first.lox", "print bump();\n"
+                              "print bump();\n"
+                              "var mine = 1;\n"
+                              "push(shared, 2);\n"
+                              "box.v = 2;\n"
+                              "set(m, \"k\", 1);\n"
+                              "print shared;\n"
+                              "print get(m, \"box\").self.v;\n");
+    write("server_second.lox", "print bump();\n"
+                               "print shared;\n"
+                               "print box.v;\n"
+                               "print get(m, \"box\") == box;\n"
+                               "print len(m);\n"
+                               "print mine;\n");
+
+    for (const bool fork : {false, true})
+    {
+        lox::Server::Options options;
+        options.socketPath = "server_test.sock";
+        options.prelude = "server_prelude.lox";
+        options.fork = fork;
+
+        // the server redirects std::cout for its scripts, it needs a process of its own
+        const pid_t server = ::fork();
+        if (server == 0)
+        {
+            lox::Lox lox;
+            std::_Exit(lox::Server{options, lox}.serve());
+        }
+
+        if (!waitForServer(options.socketPath))
+        {
+            std::cout << "the server didn't start" << std::endl;
+            ::kill(server, SIGTERM);
+            return EXIT_FAILURE;
+        }
+
+        submit(options.socketPath, "server_first.lox");
+        submit(options.socketPath, "server_second.lox");
+
+        ::kill(server, SIGTERM);
+        ::waitpid(server, nullptr, 0);
+    }
+
+    for (const char *file : {"server_prelude.lox", "server_first.lox", "server_second.lox", "server_test.sock"})
+        std::filesystem::remove(file);
+}
@@ -0,0 +1,29 @@
+// native extension for the tests, loaded with loadNative("./test_extension.so") (see LoxNative.h).
+// it defines x, the name tests use for their own globals
+
+#include "../../lox/include/LoxNative.h"
+
+namespace
+{
+lox_value twice(const lox_value *args, int, void *)
+{
+    if (args[0].type != LOX_NUMBER)
+        return lox_error("Expected a number.");
+    return lox_number(args[0].as.number * 2);
+}
+
+lox_value x(const lox_value *, int, void *)
+{
+    return lox_string("x", 1);
+}
+} // namespace
+
+extern "C" int lox_native_init(const lox_native_api *api)
+{
+    if (api->version != LOX_NATIVE_API_VERSION)
+        return 1;
+
+    api->define(api->registry, "twice", 1, twice, nullptr);
+    api->define(api->registry, "x", 0, x, nullptr);
+    return 0;
+}